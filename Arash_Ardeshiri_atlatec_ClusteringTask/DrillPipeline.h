@@ -0,0 +1,349 @@
+#ifndef DRILLPIPELINE_H
+#define DRILLPIPELINE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include "DrillPlanner.h"
+
+namespace atlatec_test
+{
+
+///fixed capacity queue between two pipeline stages, push blocks while it is full, which is the backpressure that
+///keeps a fast producer from decoding the whole batch into memory ahead of a slow consumer.
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity);
+
+    bool push(T item); ///false once the queue is closed
+    std::optional<T> pop(); ///empty once the queue is closed and drained
+    void close();
+
+private:
+    std::mutex mtx;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed;
+};
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t c):mtx{}, not_full{}, not_empty{}, items{}, capacity{std::max<size_t>(c, 1)}, closed{false}
+{}
+
+template<typename T>
+bool BoundedQueue<T>::push(T item)
+{
+    std::unique_lock<std::mutex> lock{mtx};
+    not_full.wait(lock, [this](){return closed || items.size() < capacity;});
+    if(closed)
+    {
+        return false;
+    }
+    items.push_back(std::move(item));
+    not_empty.notify_one();
+    return true;
+}
+
+template<typename T>
+std::optional<T> BoundedQueue<T>::pop()
+{
+    std::unique_lock<std::mutex> lock{mtx};
+    not_empty.wait(lock, [this](){return closed || !items.empty();});
+    if(items.empty())
+    {
+        return std::nullopt;
+    }
+    std::optional<T> res{std::move(items.front())};
+    items.pop_front();
+    not_full.notify_one();
+    return res;
+}
+
+template<typename T>
+void BoundedQueue<T>::close()
+{
+    std::lock_guard<std::mutex> lock{mtx};
+    closed = true;
+    not_full.notify_all();
+    not_empty.notify_all();
+}
+
+struct BatchSettings
+{
+    DrillSettings drills{25, 64, 1}; ///maps run side by side, so every planner scores on one thread
+    size_t workers = 0;              ///threads of the decode, score and select stages each, 0 uses every hardware thread
+    size_t queue = 4;                ///maps that may wait between two stages
+    std::string output_dir{};        ///plans go next to their maps when empty, created if missing
+};
+
+struct StageMetrics
+{
+    std::string name{};
+    size_t maps = 0;
+    double busy_seconds = 0;    ///summed over the threads of the stage
+    double starved_seconds = 0; ///waiting for the previous stage
+    double blocked_seconds = 0; ///waiting for room in the next queue, i.e. backpressure
+};
+
+struct BatchResult
+{
+    std::string map{};
+    std::string plan{}; ///file the plan went to
+    std::vector<Drill> drills{};
+    std::string error{}; ///empty when the map was planned
+};
+
+struct BatchReport
+{
+    std::vector<BatchResult> maps{}; ///in input order
+    std::vector<StageMetrics> stages{};
+    double seconds = 0;
+
+    size_t planned() const noexcept
+    {
+        return static_cast<size_t>(std::count_if(maps.begin(), maps.end(), [](const BatchResult& r){return r.error.empty();}));
+    }
+
+    double maps_per_second() const noexcept ///throughput of planned maps, failed ones do not count
+    {
+        return seconds > 0 ? static_cast<double>(planned())/seconds : 0;
+    }
+};
+
+///maps of a batch: every .png map of a directory in name order, otherwise a manifest with one path per line.
+///relative manifest entries are taken relative to the manifest, empty lines and lines starting with # are skipped.
+inline std::vector<std::string> batch_inputs(const std::string& path)
+{
+    namespace fs = std::filesystem;
+    std::vector<std::string> res;
+    if(fs::is_directory(path))
+    {
+        for(const auto& e : fs::directory_iterator{path})
+        {
+            if(e.is_regular_file() && e.path().extension() == ".png")
+            {
+                res.push_back(e.path().string());
+            }
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+    std::ifstream f{path};
+    if(!f)
+    {
+        throw image_error{"can not read " + path};
+    }
+    const fs::path dir = fs::path{path}.parent_path();
+    std::string line;
+    while(std::getline(f, line))
+    {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if(line.empty() || line.front() == '#')
+        {
+            continue;
+        }
+        const fs::path p{line};
+        res.push_back(p.is_absolute() ? p.string() : (dir/p).string());
+    }
+    return res;
+}
+
+///Plans a batch of png maps in a four stage pipeline: decode -> score -> select drills -> write plan.
+///Decode, score and select run on their own pool of worker threads, the plans are written by one thread.
+///Stages are connected by BoundedQueues, so at most (workers + queue) maps are held by any stage and a slow stage
+///throttles the ones in front of it instead of letting decoded maps pile up. The score stage builds the prefix sums
+///and the full score map, the select stage runs the greedy drill selection on it. Every plan is the one DrillPlanner
+///makes for its map. A map that fails (unreadable file, broken png) is reported in its BatchResult and the rest of
+///the batch goes on. So is a map whose plan would overwrite the plan of an earlier, different map of the batch
+///(same file name from two directories with one output_dir), a map listed twice just gets the same plan again.
+class DrillPipeline
+{
+public:
+    explicit DrillPipeline(BatchSettings settings = {});
+
+    BatchReport run(const std::vector<std::string>& maps) const;
+    std::string plan_path(const std::string& map) const; ///where the plan of map is written
+
+private:
+    struct Job
+    {
+        size_t index;
+        GrayImage image;
+        std::unique_ptr<DrillPlanner> planner;
+        std::vector<Drill> drills;
+        std::string error;
+    };
+
+    using Queue = BoundedQueue<Job>;
+
+    ///runs work on every job of in with the given number of threads and hands the jobs on to out, a job that already
+    ///failed is passed through untouched. out is closed by the last thread of the stage. The last stage (no out) sees
+    ///the failed jobs as well, it is the one that reports them.
+    template<typename F>
+    static void stage(StageMetrics& metrics, size_t threads, Queue& in, Queue* out, F work, std::vector<std::thread>& pool);
+
+    BatchSettings settings;
+};
+
+inline DrillPipeline::DrillPipeline(BatchSettings s):settings{std::move(s)}
+{
+    if(settings.workers == 0)
+    {
+        settings.workers = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    }
+}
+
+inline std::string DrillPipeline::plan_path(const std::string& map) const
+{
+    const std::string plan = plan_filename(map);
+    if(settings.output_dir.empty())
+    {
+        return plan;
+    }
+    return (std::filesystem::path{settings.output_dir}/std::filesystem::path{plan}.filename()).string();
+}
+
+template<typename F>
+void DrillPipeline::stage(StageMetrics& metrics, size_t threads, Queue& in, Queue* out, F work, std::vector<std::thread>& pool)
+{
+    auto running = std::make_shared<std::atomic<size_t>>(threads);
+    auto mtx = std::make_shared<std::mutex>();
+    for(size_t i = 0; i < threads; i++)
+    {
+        pool.emplace_back([&metrics, &in, out, work, running, mtx]()
+        {
+            using clock = std::chrono::steady_clock;
+            StageMetrics local{};
+            auto t = clock::now();
+            while(auto job = in.pop())
+            {
+                auto now = clock::now();
+                local.starved_seconds += std::chrono::duration<double>(now - t).count();
+                t = now;
+                if(job->error.empty() || !out)
+                {
+                    try
+                    {
+                        work(*job);
+                    }
+                    catch(const std::exception& e)
+                    {
+                        job->error = e.what();
+                        job->image = GrayImage{};
+                        job->planner.reset();
+                    }
+                }
+                now = clock::now();
+                local.busy_seconds += std::chrono::duration<double>(now - t).count();
+                local.maps++;
+                t = now;
+                if(out)
+                {
+                    out->push(std::move(*job));
+                    now = clock::now();
+                    local.blocked_seconds += std::chrono::duration<double>(now - t).count();
+                    t = now;
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock{*mtx};
+                metrics.maps += local.maps;
+                metrics.busy_seconds += local.busy_seconds;
+                metrics.starved_seconds += local.starved_seconds;
+                metrics.blocked_seconds += local.blocked_seconds;
+            }
+            if(--*running == 0 && out)
+            {
+                out->close();
+            }
+        });
+    }
+}
+
+inline BatchReport DrillPipeline::run(const std::vector<std::string>& maps) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    if(!settings.output_dir.empty())
+    {
+        std::filesystem::create_directories(settings.output_dir); ///before any map is decoded, not when the plans are due
+    }
+    BatchReport report{};
+    report.maps.resize(maps.size());
+    report.stages = {StageMetrics{"decode"}, StageMetrics{"score"}, StageMetrics{"select"}, StageMetrics{"write"}};
+    std::map<std::filesystem::path, std::filesystem::path> writers; ///plan -> the map it belongs to
+    for(size_t i = 0; i < maps.size(); i++)
+    {
+        report.maps[i].map = maps[i];
+        report.maps[i].plan = plan_path(maps[i]);
+        const auto map = std::filesystem::weakly_canonical(maps[i]);
+        const auto [it, first] = writers.emplace(std::filesystem::weakly_canonical(report.maps[i].plan), map);
+        if(!first && it->second != map)
+        {
+            report.maps[i].error = "plan " + report.maps[i].plan + " is already written for " + it->second.string();
+        }
+    }
+
+    Queue source{settings.queue}, decoded{settings.queue}, scored{settings.queue}, selected{settings.queue};
+    std::vector<std::thread> pool;
+    const DrillSettings drills = settings.drills;
+    stage(report.stages[0], settings.workers, source, &decoded, [&maps](Job& job)
+    {
+        job.image = load_png(maps[job.index]);
+    }, pool);
+    stage(report.stages[1], settings.workers, decoded, &scored, [drills](Job& job)
+    {
+        job.planner = std::make_unique<DrillPlanner>(std::move(job.image), drills);
+        job.planner->score();
+    }, pool);
+    stage(report.stages[2], settings.workers, scored, &selected, [](Job& job)
+    {
+        job.drills = job.planner->plan();
+        job.planner.reset();
+    }, pool);
+    stage(report.stages[3], 1, selected, nullptr, [&report](Job& job)
+    {
+        BatchResult& res = report.maps[job.index];
+        if(job.error.empty())
+        {
+            try
+            {
+                write_plan(res.plan, job.drills);
+                res.drills = std::move(job.drills);
+            }
+            catch(const std::runtime_error& e)
+            {
+                job.error = e.what();
+            }
+        }
+        res.error = job.error;
+    }, pool);
+    for(size_t i = 0; i < maps.size(); i++)
+    {
+        source.push(Job{i, GrayImage{}, nullptr, {}, report.maps[i].error});
+    }
+    source.close();
+    for(auto& t : pool)
+    {
+        t.join();
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+}
+#endif // DRILLPIPELINE_H
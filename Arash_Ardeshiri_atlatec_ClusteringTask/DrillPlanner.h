@@ -0,0 +1,461 @@
+#ifndef DRILLPLANNER_H
+#define DRILLPLANNER_H
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstddef>
+#include <queue>
+#include <thread>
+#include <limits>
+#include "DynamicMatrix.h"
+#include "ImageIO.h"
+
+namespace atlatec_test
+{
+
+struct DrillSettings
+{
+    size_t radius = 25; ///same disk as cv2.circle(..., radius, color, -1) in main.py
+    size_t drills = 64;
+    size_t threads = 0; ///for the initial scoring pass, 0 uses every hardware thread
+};
+
+struct Drill
+{
+    size_t x;
+    size_t y;
+    std::uint64_t oil; ///sum of the pixel values still inside the disk when it was drilled
+};
+
+///half-open [x0, x1) x [y0, y1) range of pixels
+struct Window
+{
+    size_t x0;
+    size_t y0;
+    size_t x1;
+    size_t y1;
+
+    bool empty() const noexcept
+    {
+        return x0 >= x1 || y0 >= y1;
+    }
+};
+
+using score_type = std::uint32_t; ///255 * (2*radius+1)^2 has to fit, see max_radius
+
+constexpr size_t max_radius = 2047;
+
+///horizontal reach of a radius r disk for every dy = -r..r, pixel (dx, dy) is inside when |dx| <= result[dy + r]
+inline std::vector<size_t> disk_half_widths(size_t radius)
+{
+    std::vector<size_t> res(2*radius + 1);
+    const double r = static_cast<double>(radius);
+    for(size_t i = 0; i < res.size(); i++)
+    {
+        const double dy = static_cast<double>(i) - r;
+        res[i] = static_cast<size_t>(std::floor(std::sqrt(r*r - dy*dy) + 1e-9));
+    }
+    return res;
+}
+
+///Exact version of drill_points() in main.py: instead of sampling 700 random centers, the disk sum of every pixel
+///is evaluated and the drill goes to the true argmax, ties resolve to the smallest (y, x) so plans are deterministic.
+///Every row keeps a prefix sum, so a disk sum is one subtraction per disk row, O(radius) per center. The prefix rows
+///are padded by radius on both sides, which lets a whole row of centers be scored without any edge clamping.
+///The full score map is computed once, split by rows over the worker threads. A drill only changes the scores of
+///centers within 2*radius of it, so only that disk is rescored and only the tiles it touches get a new maximum.
+///The best tile is found through a lazy max-heap: entries of tiles that changed since they were pushed are dropped
+///when they reach the top. Rows are scored independently, so the plan does not depend on the thread count.
+///Drill centers can be limited to a window of the map, the pixels around it still count as oil (tiles with a halo).
+class DrillPlanner
+{
+public:
+    explicit DrillPlanner(GrayImage map, DrillSettings settings = {});
+    DrillPlanner(GrayImage map, DrillSettings settings, Window centers);
+
+    size_t width() const noexcept;
+    size_t height() const noexcept;
+    const GrayImage& image() const noexcept; ///the map with every drilled disk already removed
+
+    std::uint64_t disk_sum(size_t x, size_t y) const;
+    void score_row(size_t y, score_type* out) const; ///disk sums of every center of row y
+    void score_range(size_t y, size_t x_first, size_t x_end, score_type* out) const; ///centers x_first..x_end of row y
+    void score(); ///builds the score map of every center in the window, next_drill does it on first use
+    Drill next_drill(); ///throws wrong_input when the window holds no center
+    void drill(size_t x, size_t y); ///removes the oil under the disk, like bitwise_and with the inverted mask
+    std::vector<Drill> plan();
+
+private:
+    static constexpr size_t tile = 64;
+
+    struct Candidate
+    {
+        score_type score;
+        size_t y;
+        size_t x;
+        size_t tile;
+        size_t version;
+
+        bool operator<(const Candidate& o) const noexcept ///heap order, best on top: highest score, then smallest (y, x)
+        {
+            if(score != o.score)
+            {
+                return score < o.score;
+            }
+            return y != o.y ? y > o.y : x > o.x;
+        }
+    };
+
+    void update_prefix_row(size_t y, size_t from = 0); ///entries left of from are still valid
+    const std::uint32_t* prefix_row(size_t y) const noexcept; ///points at column 0, valid from -radius to width+radius
+    void score_all();
+    Candidate best_in_tile(size_t t) const;
+    void refresh_tile(size_t t);
+
+    DrillSettings settings;
+    GrayImage map;
+    Window window;
+    DynamicMatrix<std::uint32_t> prefix; ///height x (width+2*radius+1), prefix_row(y)[x] = sum of map[y][0..x)
+    std::vector<size_t> half_width;      ///horizontal reach of the disk for dy = -radius..radius
+    DynamicMatrix<score_type> scores;    ///disk sum of every center on the current map
+    size_t tiles_x;
+    size_t tiles_y;
+    std::vector<size_t> tile_version;
+    std::priority_queue<Candidate> heap;
+    bool scored;
+};
+
+inline DrillPlanner::DrillPlanner(GrayImage m, DrillSettings s):DrillPlanner{std::move(m), s, Window{0, 0, size_t(-1), size_t(-1)}}
+{}
+
+inline DrillPlanner::DrillPlanner(GrayImage m, DrillSettings s, Window c):settings{s}, map{std::move(m)},
+    window{c.x0, c.y0, std::min(c.x1, map.cols()), std::min(c.y1, map.rows())}, prefix(map.rows(), map.cols() + 2*s.radius + 1),
+    half_width(disk_half_widths(s.radius)), scores{}, tiles_x{(map.cols() + tile - 1)/tile}, tiles_y{(map.rows() + tile - 1)/tile},
+    tile_version(tiles_x*tiles_y, 0), heap{}, scored{false}
+{
+    if(settings.radius > max_radius)
+    {
+        throw wrong_input{"drill radius too large for the score type."};
+    }
+    for(size_t y = 0; y < height(); y++)
+    {
+        update_prefix_row(y);
+    }
+}
+
+inline size_t DrillPlanner::width() const noexcept
+{
+    return map.cols();
+}
+
+inline size_t DrillPlanner::height() const noexcept
+{
+    return map.rows();
+}
+
+inline const GrayImage& DrillPlanner::image() const noexcept
+{
+    return map;
+}
+
+inline void DrillPlanner::update_prefix_row(size_t y, size_t from)
+{
+    const std::uint8_t* row = map.begin() + y*width();
+    std::uint32_t* p = prefix.begin() + y*prefix.cols();
+    std::fill(p, p + settings.radius + 1, 0);
+    p += settings.radius;
+    for(size_t x = from; x < width(); x++)
+    {
+        p[x+1] = p[x] + row[x];
+    }
+    std::fill(p + width() + 1, p + width() + settings.radius + 1, p[width()]);
+}
+
+inline const std::uint32_t* DrillPlanner::prefix_row(size_t y) const noexcept
+{
+    return prefix.begin() + y*prefix.cols() + settings.radius;
+}
+
+inline std::uint64_t DrillPlanner::disk_sum(size_t x, size_t y) const
+{
+    const size_t r = settings.radius;
+    const size_t y_first = y >= r ? y - r : 0;
+    const size_t y_last = std::min(y + r, height() - 1);
+    std::uint64_t sum = 0;
+    for(size_t yy = y_first; yy <= y_last; yy++)
+    {
+        const std::ptrdiff_t w = half_width[yy + r - y];
+        const std::uint32_t* p = prefix_row(yy) + x;
+        sum += p[w + 1] - p[-w];
+    }
+    return sum;
+}
+
+inline void DrillPlanner::score_row(size_t y, score_type* out) const
+{
+    score_range(y, 0, width(), out);
+}
+
+inline void DrillPlanner::score_range(size_t y, size_t x_first, size_t x_end, score_type* out) const
+{
+    const size_t r = settings.radius;
+    const size_t y_first = y >= r ? y - r : 0;
+    const size_t y_last = std::min(y + r, height() - 1);
+    const size_t n = x_end - x_first;
+    std::fill(out, out + n, 0);
+    for(size_t yy = y_first; yy <= y_last; yy++)
+    {
+        const std::ptrdiff_t w = half_width[yy + r - y];
+        const std::uint32_t* hi = prefix_row(yy) + x_first + w + 1;
+        const std::uint32_t* lo = prefix_row(yy) + x_first - w;
+        for(size_t x = 0; x < n; x++)
+        {
+            out[x] += hi[x] - lo[x];
+        }
+    }
+}
+
+inline void DrillPlanner::score_all()
+{
+    scores = DynamicMatrix<score_type>(height(), width());
+    size_t workers = settings.threads ? settings.threads : std::thread::hardware_concurrency();
+    workers = std::clamp<size_t>(workers, 1, std::max<size_t>(window.y1 - window.y0, 1));
+    auto run = [this, workers](auto&& job, size_t jobs)
+    {
+        std::vector<std::thread> pool;
+        for(size_t w = 1; w < workers; w++)
+        {
+            pool.emplace_back([&job, jobs, w, workers]()
+            {
+                for(size_t i = jobs*w/workers; i < jobs*(w+1)/workers; i++)
+                {
+                    job(i);
+                }
+            });
+        }
+        for(size_t i = 0; i < jobs/workers; i++)
+        {
+            job(i);
+        }
+        for(auto& t : pool)
+        {
+            t.join();
+        }
+    };
+    run([this](size_t i)
+    {
+        const size_t y = window.y0 + i;
+        score_range(y, window.x0, window.x1, scores.begin() + y*width() + window.x0);
+    }, window.y1 - window.y0);
+
+    const size_t tx0 = window.x0/tile, ty0 = window.y0/tile;
+    const size_t tw = (window.x1 - 1)/tile - tx0 + 1, th = (window.y1 - 1)/tile - ty0 + 1;
+    std::vector<Candidate> best(tw*th);
+    run([this, &best, tx0, ty0, tw](size_t i)
+    {
+        best[i] = best_in_tile((ty0 + i/tw)*tiles_x + tx0 + i%tw);
+    }, best.size());
+    for(const auto& c : best)
+    {
+        heap.push(c);
+    }
+    scored = true;
+}
+
+inline DrillPlanner::Candidate DrillPlanner::best_in_tile(size_t t) const
+{
+    const size_t y_first = std::max((t / tiles_x)*tile, window.y0), x_first = std::max((t % tiles_x)*tile, window.x0);
+    const size_t y_end = std::min((t / tiles_x + 1)*tile, window.y1), x_end = std::min((t % tiles_x + 1)*tile, window.x1);
+    Candidate best{0, y_first, x_first, t, tile_version[t]};
+    for(size_t y = y_first; y < y_end; y++)
+    {
+        const score_type* row = scores.begin() + y*width();
+        const score_type* it = std::max_element(row + x_first, row + x_end);
+        if(*it > best.score)
+        {
+            best.score = *it;
+            best.y = y;
+            best.x = static_cast<size_t>(it - row);
+        }
+    }
+    return best;
+}
+
+inline void DrillPlanner::refresh_tile(size_t t)
+{
+    tile_version[t]++;
+    heap.push(best_in_tile(t));
+}
+
+inline void DrillPlanner::score()
+{
+    if(scored)
+    {
+        return;
+    }
+    if(window.empty())
+    {
+        scored = true;
+        return;
+    }
+    score_all();
+}
+
+inline Drill DrillPlanner::next_drill()
+{
+    score();
+    if(heap.empty())
+    {
+        throw wrong_input{"no drill center in the window."};
+    }
+    while(heap.top().version != tile_version[heap.top().tile])
+    {
+        heap.pop();
+    }
+    const Candidate& c = heap.top();
+    return Drill{c.x, c.y, c.score};
+}
+
+inline void DrillPlanner::drill(size_t x, size_t y)
+{
+    const size_t r = settings.radius;
+    const size_t y_first = y >= r ? y - r : 0;
+    const size_t y_last = std::min(y + r, height() - 1);
+    for(size_t yy = y_first; yy <= y_last; yy++)
+    {
+        const size_t w = half_width[yy + r - y];
+        const size_t x_first = x >= w ? x - w : 0;
+        const size_t x_end = std::min(x + w + 1, width());
+        std::uint8_t* row = map.begin() + yy*width();
+        std::fill(row + x_first, row + x_end, std::uint8_t{0});
+        update_prefix_row(yy, x_first);
+    }
+    if(!scored)
+    {
+        return;
+    }
+    const size_t reach = 2*r;
+    const size_t box_y0 = std::max(y >= reach ? y - reach : 0, window.y0), box_y1 = std::min(y + reach + 1, window.y1);
+    const size_t box_x0 = std::max(x >= reach ? x - reach : 0, window.x0), box_x1 = std::min(x + reach + 1, window.x1);
+    if(box_y0 >= box_y1 || box_x0 >= box_x1)
+    {
+        return;
+    }
+    for(size_t yy = box_y0; yy < box_y1; yy++)
+    {
+        const size_t dy = yy > y ? yy - y : y - yy;
+        const size_t w = static_cast<size_t>(std::sqrt(static_cast<double>(reach*reach - dy*dy)) + 1e-9);
+        const size_t x0 = std::max(x >= w ? x - w : 0, box_x0), x_end = std::min(x + w + 1, box_x1);
+        if(x0 < x_end)
+        {
+            score_range(yy, x0, x_end, scores.begin() + yy*width() + x0);
+        }
+    }
+    for(size_t ty = box_y0/tile; ty <= (box_y1 - 1)/tile; ty++)
+    {
+        for(size_t tx = box_x0/tile; tx <= (box_x1 - 1)/tile; tx++)
+        {
+            refresh_tile(ty*tiles_x + tx);
+        }
+    }
+}
+
+inline std::vector<Drill> DrillPlanner::plan()
+{
+    std::vector<Drill> res;
+    res.reserve(settings.drills);
+    if(window.empty())
+    {
+        return res;
+    }
+    for(size_t i = 0; i < settings.drills; i++)
+    {
+        const Drill d = next_drill();
+        drill(d.x, d.y);
+        res.push_back(d);
+    }
+    return res;
+}
+
+///same naming as main.py: ./pics/oil1.png -> ./pics/oil1_drilling_plan.txt, .pgm and .raw maps are named alike
+inline std::string plan_filename(const std::string& map_filename)
+{
+    std::string base = map_filename;
+    for(const std::string suffix : {".png", ".pgm", ".raw"})
+    {
+        if(base.size() >= suffix.size() && base.compare(base.size() - suffix.size(), suffix.size(), suffix) == 0)
+        {
+            base.erase(base.size() - suffix.size());
+            break;
+        }
+    }
+    return base + "_drilling_plan.txt";
+}
+
+///one "x y" line per drill, exactly what main.py prints.
+inline void write_plan(const std::string& filename, const std::vector<Drill>& drills)
+{
+    std::ofstream f{filename};
+    if(!f)
+    {
+        throw image_error{"can not write " + filename};
+    }
+    for(const auto& d : drills)
+    {
+        f<<d.x<<' '<<d.y<<'\n';
+    }
+}
+
+///reads a plan written by write_plan or main.py, the oil of the drills is left at 0.
+inline std::vector<Drill> read_plan(const std::string& filename)
+{
+    std::ifstream f{filename};
+    if(!f)
+    {
+        throw image_error{"can not read " + filename};
+    }
+    std::vector<Drill> res;
+    size_t x = 0, y = 0;
+    while(f>>x>>y)
+    {
+        res.push_back(Drill{x, y, 0});
+    }
+    if(!f.eof())
+    {
+        throw image_error{"broken plan " + filename};
+    }
+    return res;
+}
+
+///drills the plan on a copy of the map in order and fills in the oil of every drill, returns the total.
+///main.py may place centers on the right and bottom border (randint is inclusive), disks are clipped like cv2.circle.
+inline std::uint64_t plan_oil(GrayImage map, std::vector<Drill>& drills, size_t radius)
+{
+    const auto half_width = disk_half_widths(radius);
+    std::uint64_t total = 0;
+    for(auto& d : drills)
+    {
+        d.oil = 0;
+        const size_t y_first = d.y >= radius ? d.y - radius : 0, y_end = std::min(d.y + radius + 1, map.rows());
+        for(size_t y = y_first; y < y_end; y++)
+        {
+            const size_t w = half_width[y + radius - d.y];
+            const size_t x_first = d.x >= w ? d.x - w : 0, x_end = std::min(d.x + w + 1, map.cols());
+            std::uint8_t* row = map.begin() + y*map.cols();
+            for(size_t x = x_first; x < x_end; x++)
+            {
+                d.oil += row[x];
+                row[x] = 0;
+            }
+        }
+        total += d.oil;
+    }
+    return total;
+}
+
+}
+#endif // DRILLPLANNER_H
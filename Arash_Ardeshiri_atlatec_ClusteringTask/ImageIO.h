@@ -0,0 +1,237 @@
+#ifndef IMAGEIO_H
+#define IMAGEIO_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <cctype>
+#include <png.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "DynamicMatrix.h"
+
+namespace atlatec_test
+{
+
+using GrayImage = DynamicMatrix<std::uint8_t>;
+
+class image_error: public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+///reads any png as 8 bit grayscale, the same thing cv2.imread(filename, cv2.IMREAD_GRAYSCALE) gives main.py.
+inline GrayImage load_png(const std::string& filename)
+{
+    png_image img{};
+    img.version = PNG_IMAGE_VERSION;
+    if(!png_image_begin_read_from_file(&img, filename.c_str()))
+    {
+        throw image_error{"can not read " + filename + ": " + img.message};
+    }
+    img.format = PNG_FORMAT_GRAY;
+    std::valarray<std::uint8_t> pixels(PNG_IMAGE_SIZE(img));
+    if(!png_image_finish_read(&img, nullptr, std::begin(pixels), 0, nullptr))
+    {
+        png_image_free(&img);
+        throw image_error{"can not decode " + filename + ": " + img.message};
+    }
+    return GrayImage{img.height, img.width, std::move(pixels)};
+}
+
+///read-only memory mapping of an 8 bit grayscale map stored as binary pgm (P5) or as headerless raw bytes.
+///nothing is read until a pixel is touched, so maps far larger than RAM can be walked tile by tile.
+class MappedImage
+{
+public:
+    static MappedImage open_pgm(const std::string& filename);
+    static MappedImage open_raw(const std::string& filename, size_t width, size_t height);
+
+    ~MappedImage();
+    MappedImage(const MappedImage&) = delete;
+    MappedImage& operator=(const MappedImage&) = delete;
+    MappedImage(MappedImage&& o) noexcept;
+    MappedImage& operator=(MappedImage&&) = delete;
+
+    size_t width() const noexcept;
+    size_t height() const noexcept;
+    const std::uint8_t* row(size_t y) const noexcept;
+    std::uint8_t at(size_t y, size_t x) const noexcept;
+
+    GrayImage region(size_t x0, size_t y0, size_t x1, size_t y1) const; ///copy of [x0, x1) x [y0, y1)
+    void release_rows(size_t y0, size_t y1) const noexcept; ///lets the kernel drop the pages of rows [y0, y1)
+
+private:
+    explicit MappedImage(const std::string& filename);
+
+    int fd;
+    std::uint8_t* base;
+    size_t length;
+    const std::uint8_t* pixels;
+    size_t _width;
+    size_t _height;
+};
+
+inline MappedImage::MappedImage(const std::string& filename):fd{::open(filename.c_str(), O_RDONLY)}, base{nullptr}, length{0}, pixels{nullptr},
+    _width{0}, _height{0}
+{
+    struct stat st{};
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+        throw image_error{"can not read " + filename};
+    }
+    length = static_cast<size_t>(st.st_size);
+    if(length > 0)
+    {
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED)
+        {
+            ::close(fd);
+            throw image_error{"can not map " + filename};
+        }
+        base = static_cast<std::uint8_t*>(p);
+    }
+    pixels = base;
+}
+
+inline MappedImage::MappedImage(MappedImage&& o) noexcept:fd{o.fd}, base{o.base}, length{o.length}, pixels{o.pixels}, _width{o._width}, _height{o._height}
+{
+    o.fd = -1;
+    o.base = nullptr;
+    o.length = 0;
+}
+
+inline MappedImage::~MappedImage()
+{
+    if(base)
+    {
+        ::munmap(base, length);
+    }
+    if(fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+inline MappedImage MappedImage::open_pgm(const std::string& filename)
+{
+    MappedImage img{filename};
+    size_t pos = 0;
+    auto next_token = [&img, &pos, &filename]()
+    {
+        while(pos < img.length && (std::isspace(img.base[pos]) || img.base[pos] == '#'))
+        {
+            if(img.base[pos] == '#')
+            {
+                while(pos < img.length && img.base[pos] != '\n')
+                {
+                    pos++;
+                }
+            }
+            else
+            {
+                pos++;
+            }
+        }
+        std::string token;
+        while(pos < img.length && !std::isspace(img.base[pos]))
+        {
+            token.push_back(static_cast<char>(img.base[pos++]));
+        }
+        if(token.empty())
+        {
+            throw image_error{"broken pgm header in " + filename};
+        }
+        return token;
+    };
+    if(next_token() != "P5")
+    {
+        throw image_error{filename + " is not a binary pgm (P5)."};
+    }
+    try
+    {
+        img._width = std::stoul(next_token());
+        img._height = std::stoul(next_token());
+        if(std::stoul(next_token()) > 255)
+        {
+            throw image_error{"only 8 bit pgm maps are supported: " + filename};
+        }
+    }
+    catch(const std::logic_error&)
+    {
+        throw image_error{"broken pgm header in " + filename};
+    }
+    pos++; ///the single whitespace after maxval
+    if(img.length < pos || img.length - pos < img._width*img._height)
+    {
+        throw image_error{"truncated pgm " + filename};
+    }
+    img.pixels = img.base + pos;
+    return img;
+}
+
+inline MappedImage MappedImage::open_raw(const std::string& filename, size_t width, size_t height)
+{
+    MappedImage img{filename};
+    if(img.length < width*height)
+    {
+        throw image_error{"truncated raw map " + filename};
+    }
+    img._width = width;
+    img._height = height;
+    return img;
+}
+
+inline size_t MappedImage::width() const noexcept
+{
+    return _width;
+}
+
+inline size_t MappedImage::height() const noexcept
+{
+    return _height;
+}
+
+inline const std::uint8_t* MappedImage::row(size_t y) const noexcept
+{
+    return pixels + y*_width;
+}
+
+inline std::uint8_t MappedImage::at(size_t y, size_t x) const noexcept
+{
+    return pixels[y*_width + x];
+}
+
+inline GrayImage MappedImage::region(size_t x0, size_t y0, size_t x1, size_t y1) const
+{
+    GrayImage res(y1 - y0, x1 - x0);
+    for(size_t y = y0; y < y1; y++)
+    {
+        std::copy(row(y) + x0, row(y) + x1, res.begin() + (y - y0)*res.cols());
+    }
+    return res;
+}
+
+inline void MappedImage::release_rows(size_t y0, size_t y1) const noexcept
+{
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t first = static_cast<size_t>(row(y0) - base);
+    const size_t last = static_cast<size_t>(row(y1) - base);
+    const size_t aligned = (first + page - 1)/page*page; ///pages shared with rows still in use are kept
+    if(last > aligned)
+    {
+        ::madvise(base + aligned, (last - aligned)/page*page, MADV_DONTNEED);
+    }
+}
+
+}
+#endif // IMAGEIO_H
@@ -0,0 +1,234 @@
+#ifndef TILEDDRILLPLANNER_H
+#define TILEDDRILLPLANNER_H
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include "DrillPlanner.h"
+#include "ImageIO.h"
+
+namespace atlatec_test
+{
+
+struct TileSettings
+{
+    size_t tile = 1024;    ///edge of the part of a tile that may hold drills, a halo of radius pixels comes on top
+    size_t candidates = 0; ///picks a tile may offer at most, 0 offers as many as drills are planned
+    size_t pool = 0;       ///candidates kept across all tiles for the global merge, 0 keeps 16 per planned drill
+};
+
+///Plans drills on a memory-mapped map one tile at a time, so peak memory depends on the tile size and not on the map.
+///Every tile is copied with a halo as wide as the drill radius, which keeps the disk sums of its own centers exact,
+///and the DrillPlanner greedy runs on it with the drill centers limited to the tile. Any tile may hold all of the oil,
+///so each one offers up to settings.drills picks to a bounded pool ranked by the oil they reach within their tile.
+///A tile's picks only get weaker, so it stops as soon as one of them would not make it into a full pool or is dry.
+///The pages of finished tile rows are dropped. The pool is then merged greedily: every candidate starts with its
+///untouched disk sum, one whose score predates the last accepted drill is rescored straight from the mapping against
+///the drills around it and pushed back. Scores only shrink as drills are added, so a fresh candidate on top of the
+///heap is the exact best of the pool. The plan is therefore greedy over per-tile candidates, an approximation of the
+///untiled plan. When the whole map fits into one tile it is the DrillPlanner plan.
+class TiledDrillPlanner
+{
+public:
+    TiledDrillPlanner(const MappedImage& map, DrillSettings settings = {}, TileSettings tiles = {});
+
+    std::vector<Drill> plan(); ///fewer drills than asked for when the pool runs out, dry tiles offer no picks
+    size_t peak_tile_bytes() const noexcept; ///largest working set of a single tile: pixels, prefix sums and scores
+
+private:
+    struct Candidate
+    {
+        std::uint64_t oil;
+        size_t y;
+        size_t x;
+        size_t stamp; ///number of accepted drills when oil was computed
+
+        bool operator<(const Candidate& o) const noexcept ///heap order, best on top: most oil, then smallest (y, x)
+        {
+            if(oil != o.oil)
+            {
+                return oil < o.oil;
+            }
+            return y != o.y ? y > o.y : x > o.x;
+        }
+    };
+
+    struct Weaker ///reversed heap order, the weakest candidate of the bounded pool stays on top
+    {
+        bool operator()(const Candidate& a, const Candidate& b) const noexcept
+        {
+            return b < a;
+        }
+    };
+
+    using Pool = std::priority_queue<Candidate, std::vector<Candidate>, Weaker>; ///ranked by the oil reached within the tile
+
+    std::uint64_t remaining_oil(size_t x, size_t y) const; ///disk sum without the pixels of accepted drills
+    void accept(const Candidate& c);
+    void plan_tile(size_t x0, size_t y0, size_t x1, size_t y1, Pool& pool);
+
+    const MappedImage& map;
+    DrillSettings settings;
+    TileSettings tiles;
+    std::vector<size_t> half_width;
+    std::vector<Drill> chosen;
+    std::unordered_map<size_t, std::vector<size_t>> grid; ///cells of 2*radius+1 pixels -> indices into chosen
+    size_t cell;
+    size_t cells_x;
+    size_t peak;
+};
+
+inline TiledDrillPlanner::TiledDrillPlanner(const MappedImage& m, DrillSettings s, TileSettings t):map{m}, settings{s}, tiles{t},
+    half_width{}, chosen{}, grid{}, cell{2*s.radius + 1}, cells_x{m.width()/(2*s.radius + 1) + 2}, peak{0}
+{
+    if(settings.radius > max_radius || tiles.tile == 0)
+    {
+        throw wrong_input{"wrong input!"};
+    }
+    half_width = disk_half_widths(settings.radius);
+    if(tiles.pool == 0)
+    {
+        tiles.pool = 16*settings.drills;
+    }
+}
+
+inline size_t TiledDrillPlanner::peak_tile_bytes() const noexcept
+{
+    return peak;
+}
+
+inline std::uint64_t TiledDrillPlanner::remaining_oil(size_t x, size_t y) const
+{
+    std::vector<const Drill*> near;
+    const size_t cx = x/cell, cy = y/cell;
+    for(size_t gy = cy ? cy - 1 : 0; gy <= cy + 1; gy++)
+    {
+        for(size_t gx = cx ? cx - 1 : 0; gx <= cx + 1; gx++)
+        {
+            const auto it = grid.find(gy*cells_x + gx);
+            if(it != grid.end())
+            {
+                for(size_t i : it->second)
+                {
+                    near.push_back(&chosen[i]);
+                }
+            }
+        }
+    }
+    const size_t r = settings.radius;
+    const size_t y_first = y >= r ? y - r : 0, y_last = std::min(y + r, map.height() - 1);
+    std::uint64_t sum = 0;
+    for(size_t yy = y_first; yy <= y_last; yy++)
+    {
+        const size_t w = half_width[yy + r - y];
+        const size_t x_first = x >= w ? x - w : 0, x_end = std::min(x + w + 1, map.width());
+        const std::uint8_t* row = map.row(yy);
+        for(size_t xx = x_first; xx < x_end; xx++)
+        {
+            const bool drilled = std::any_of(near.begin(), near.end(), [this, xx, yy, r](const Drill* d)
+            {
+                const size_t dy = yy > d->y ? yy - d->y : d->y - yy;
+                const size_t dx = xx > d->x ? xx - d->x : d->x - xx;
+                return dy <= r && dx <= half_width[dy + r];
+            });
+            sum += drilled ? 0 : row[xx];
+        }
+    }
+    return sum;
+}
+
+inline void TiledDrillPlanner::accept(const Candidate& c)
+{
+    grid[(c.y/cell)*cells_x + c.x/cell].push_back(chosen.size());
+    chosen.push_back(Drill{c.x, c.y, c.oil});
+}
+
+inline void TiledDrillPlanner::plan_tile(size_t x0, size_t y0, size_t x1, size_t y1, Pool& pool)
+{
+    const size_t r = settings.radius;
+    const size_t hx0 = x0 >= r ? x0 - r : 0, hy0 = y0 >= r ? y0 - r : 0;
+    const size_t hx1 = std::min(x1 + r, map.width()), hy1 = std::min(y1 + r, map.height());
+    const size_t rows = hy1 - hy0, cols = hx1 - hx0;
+    peak = std::max(peak, rows*cols*(sizeof(std::uint8_t) + sizeof(score_type)) + rows*(cols + 2*r + 1)*sizeof(std::uint32_t));
+    const Window core{x0 - hx0, y0 - hy0, x1 - hx0, y1 - hy0};
+    if(core.empty())
+    {
+        return;
+    }
+    DrillPlanner planner{map.region(hx0, hy0, hx1, hy1), settings, core};
+    const size_t picks = tiles.candidates ? std::min(tiles.candidates, settings.drills) : settings.drills;
+    for(size_t i = 0; i < picks; i++)
+    {
+        const Drill d = planner.next_drill();
+        if(d.oil == 0)
+        {
+            return; ///the tile is dry, every later pick would be this same empty center again
+        }
+        const Candidate c{d.oil, d.y + hy0, d.x + hx0, 0};
+        if(pool.size() == tiles.pool)
+        {
+            if(!(pool.top() < c))
+            {
+                return; ///the picks left are no better than this one
+            }
+            pool.pop();
+        }
+        pool.push(c);
+        planner.drill(d.x, d.y);
+    }
+}
+
+inline std::vector<Drill> TiledDrillPlanner::plan()
+{
+    chosen.clear();
+    grid.clear();
+    if(map.width() == 0 || map.height() == 0)
+    {
+        return chosen;
+    }
+    Pool pool;
+    for(size_t y0 = 0; y0 < map.height(); y0 += tiles.tile)
+    {
+        const size_t y1 = std::min(y0 + tiles.tile, map.height());
+        for(size_t x0 = 0; x0 < map.width(); x0 += tiles.tile)
+        {
+            plan_tile(x0, y0, std::min(x0 + tiles.tile, map.width()), y1, pool);
+        }
+        ///the next row of tiles starts reading radius rows above y1
+        map.release_rows(0, std::min(y1 >= settings.radius ? y1 - settings.radius : 0, map.height()));
+    }
+
+    std::vector<Candidate> all;
+    all.reserve(pool.size());
+    while(!pool.empty())
+    {
+        Candidate c = pool.top();
+        c.oil = remaining_oil(c.x, c.y); ///nothing is accepted yet, this is the untouched disk sum
+        all.push_back(c);
+        pool.pop();
+    }
+    std::priority_queue<Candidate> heap{std::less<Candidate>{}, std::move(all)};
+    chosen.reserve(std::min(settings.drills, heap.size()));
+    while(chosen.size() < settings.drills && !heap.empty())
+    {
+        Candidate c = heap.top();
+        heap.pop();
+        if(c.stamp == chosen.size())
+        {
+            accept(c);
+        }
+        else
+        {
+            c.oil = remaining_oil(c.x, c.y);
+            c.stamp = chosen.size();
+            heap.push(c);
+        }
+    }
+    map.release_rows(0, map.height());
+    return chosen;
+}
+
+}
+#endif // TILEDDRILLPLANNER_H
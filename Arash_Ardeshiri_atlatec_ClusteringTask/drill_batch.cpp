@@ -0,0 +1,155 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "DrillPipeline.h"
+
+///Batch mode of drill_planner: plans every map of a directory or manifest through the staged pipeline.
+///usage: ./drill_batch [--drills N] [--radius R] [--workers W] [--queue Q] [--repeat K] [--out DIR] [--compare] <dir|manifest>
+///--repeat runs the batch K times in one pipeline to measure throughput on a handful of maps,
+///--compare reports how much oil the plans already next to the maps (the ones main.py wrote) reach against the new
+///plans, it needs --out pointing somewhere else so the baselines are never replaced.
+
+namespace
+{
+
+void print_stages(const atlatec_test::BatchReport& report)
+{
+    std::cout<<std::left<<std::setw(10)<<"stage"<<std::right<<std::setw(8)<<"maps"<<std::setw(12)<<"busy s"
+             <<std::setw(12)<<"starved s"<<std::setw(12)<<"blocked s"<<std::setw(12)<<"ms/map"<<std::endl;
+    for(const auto& s : report.stages)
+    {
+        std::cout<<std::left<<std::setw(10)<<s.name<<std::right<<std::setw(8)<<s.maps<<std::fixed<<std::setprecision(3)
+                 <<std::setw(12)<<s.busy_seconds<<std::setw(12)<<s.starved_seconds<<std::setw(12)<<s.blocked_seconds
+                 <<std::setw(12)<<(s.maps ? 1000.0*s.busy_seconds/static_cast<double>(s.maps) : 0.0)<<std::endl;
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    atlatec_test::BatchSettings settings{};
+    size_t repeat = 1;
+    bool compare = false;
+    std::string input;
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if((arg == "--drills" || arg == "--radius") && i + 1 < argc)
+            {
+                (arg == "--drills" ? settings.drills.drills : settings.drills.radius) = std::stoul(argv[++i]);
+            }
+            else if((arg == "--workers" || arg == "--queue" || arg == "--repeat") && i + 1 < argc)
+            {
+                (arg == "--workers" ? settings.workers : arg == "--queue" ? settings.queue : repeat) = std::stoul(argv[++i]);
+            }
+            else if(arg == "--out" && i + 1 < argc)
+            {
+                settings.output_dir = argv[++i];
+            }
+            else if(arg == "--compare")
+            {
+                compare = true;
+            }
+            else
+            {
+                input = arg;
+            }
+        }
+    }
+    catch(const std::logic_error& e)
+    {
+        input.clear();
+    }
+    if(input.empty())
+    {
+        std::cerr<<"usage: "<<argv[0]<<" [--drills N] [--radius R] [--workers W] [--queue Q] [--repeat K] [--out DIR] [--compare] <dir|manifest>"<<std::endl;
+        return 1;
+    }
+    try
+    {
+        const auto maps = atlatec_test::batch_inputs(input);
+        const atlatec_test::DrillPipeline pipeline{settings};
+        if(compare && settings.output_dir.empty())
+        {
+            std::cerr<<"--compare needs --out DIR, the new plans would replace the baselines next to the maps."<<std::endl;
+            return 1;
+        }
+        for(size_t i = 0; compare && i < maps.size(); i++)
+        {
+            const auto baseline = std::filesystem::weakly_canonical(atlatec_test::plan_filename(maps[i]));
+            if(baseline == std::filesystem::weakly_canonical(pipeline.plan_path(maps[i])))
+            {
+                std::cerr<<"--out would replace the baseline "<<baseline.string()<<", pick another directory."<<std::endl;
+                return 1;
+            }
+        }
+        std::vector<std::vector<atlatec_test::Drill>> baselines(maps.size());
+        std::vector<bool> has_baseline(maps.size(), false);
+        for(size_t i = 0; compare && i < maps.size(); i++)
+        {
+            try
+            {
+                baselines[i] = atlatec_test::read_plan(atlatec_test::plan_filename(maps[i]));
+                has_baseline[i] = true;
+            }
+            catch(const atlatec_test::image_error&)
+            {
+            }
+        }
+
+        std::vector<std::string> batch;
+        for(size_t k = 0; k < std::max<size_t>(repeat, 1); k++)
+        {
+            batch.insert(batch.end(), maps.begin(), maps.end());
+        }
+        const auto report = pipeline.run(batch);
+        size_t failed = 0;
+        for(const auto& r : report.maps)
+        {
+            if(!r.error.empty())
+            {
+                failed++;
+                std::cerr<<r.map<<": "<<r.error<<std::endl;
+            }
+        }
+        print_stages(report);
+        std::cout<<report.planned()<<" of "<<report.maps.size()<<" maps planned in "<<std::setprecision(3)
+                 <<report.seconds<<" s, "<<std::setprecision(2)<<report.maps_per_second()<<" planned maps/s"<<std::endl;
+
+        if(compare)
+        {
+            std::cout<<std::left<<std::setw(32)<<"map"<<std::right<<std::setw(12)<<"total oil"<<std::setw(12)<<"baseline"
+                     <<std::setw(12)<<"plan"<<std::setw(10)<<"ratio"<<std::endl;
+            for(size_t i = 0; i < maps.size(); i++)
+            {
+                if(!has_baseline[i] || !report.maps[i].error.empty())
+                {
+                    continue;
+                }
+                const auto img = atlatec_test::load_png(maps[i]);
+                std::uint64_t total = 0;
+                for(auto p : img)
+                {
+                    total += p;
+                }
+                const auto base = atlatec_test::plan_oil(img, baselines[i], settings.drills.radius);
+                auto drills = report.maps[i].drills;
+                const auto ours = atlatec_test::plan_oil(img, drills, settings.drills.radius);
+                const double t = total ? static_cast<double>(total) : 1.0;
+                std::cout<<std::left<<std::setw(32)<<maps[i]<<std::right<<std::setw(12)<<total<<std::setprecision(1)
+                         <<std::setw(11)<<100.0*static_cast<double>(base)/t<<'%'<<std::setw(11)<<100.0*static_cast<double>(ours)/t<<'%'
+                         <<std::setw(10)<<std::setprecision(3)<<(base ? static_cast<double>(ours)/static_cast<double>(base) : 0.0)<<std::endl;
+            }
+        }
+        return failed ? 1 : 0;
+    }
+    catch(const std::runtime_error& e)
+    {
+        std::cerr<<e.what()<<std::endl;
+        return 1;
+    }
+}
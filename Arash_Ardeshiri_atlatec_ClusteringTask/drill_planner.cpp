@@ -0,0 +1,87 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <optional>
+#include "DrillPlanner.h"
+#include "TiledDrillPlanner.h"
+
+///C++ counterpart of main.py, usage: ./drill_planner [--drills N] [--radius R] [--threads T] ./pics/oil1.png
+///writes ./pics/oil1_drilling_plan.txt in the same "x y" per line format.
+///maps larger than RAM are given as binary pgm or as raw 8 bit pixels (--raw W H), they are memory mapped and planned
+///tile by tile, --tile N sets the tile edge.
+
+int main(int argc, char** argv)
+{
+    atlatec_test::DrillSettings settings{};
+    atlatec_test::TileSettings tiles{};
+    bool tiled = false;
+    std::optional<std::pair<size_t, size_t>> raw;
+    std::string filename;
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if((arg == "--drills" || arg == "--radius" || arg == "--threads") && i + 1 < argc)
+            {
+                const size_t v = std::stoul(argv[++i]);
+                (arg == "--drills" ? settings.drills : arg == "--radius" ? settings.radius : settings.threads) = v;
+            }
+            else if(arg == "--tile" && i + 1 < argc)
+            {
+                tiles.tile = std::stoul(argv[++i]);
+                tiled = true;
+            }
+            else if(arg == "--raw" && i + 2 < argc)
+            {
+                const size_t w = std::stoul(argv[++i]);
+                raw = std::make_pair(w, std::stoul(argv[++i]));
+            }
+            else
+            {
+                filename = arg;
+            }
+        }
+    }
+    catch(const std::logic_error& e)
+    {
+        filename.clear();
+    }
+    if(filename.empty())
+    {
+        std::cerr<<"usage: "<<argv[0]<<" [--drills N] [--radius R] [--threads T] [--tile N] [--raw W H] <map.png|map.pgm|map.raw>"<<std::endl;
+        return 1;
+    }
+    const bool pgm = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".pgm") == 0;
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<atlatec_test::Drill> drills;
+        if(raw || pgm)
+        {
+            const auto map = raw ? atlatec_test::MappedImage::open_raw(filename, raw->first, raw->second)
+                                 : atlatec_test::MappedImage::open_pgm(filename);
+            atlatec_test::TiledDrillPlanner planner{map, settings, tiles};
+            drills = planner.plan();
+            std::cout<<"largest tile working set "<<planner.peak_tile_bytes()/(1024*1024)<<" MiB"<<std::endl;
+        }
+        else if(tiled)
+        {
+            throw atlatec_test::image_error{"--tile needs a memory mapped map (.pgm or --raw W H)."};
+        }
+        else
+        {
+            atlatec_test::DrillPlanner planner{atlatec_test::load_png(filename), settings};
+            drills = planner.plan();
+        }
+        atlatec_test::write_plan(atlatec_test::plan_filename(filename), drills);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout<<drills.size()<<" drills planned in "<<seconds<<" s"<<std::endl;
+    }
+    catch(const std::runtime_error& e)
+    {
+        std::cerr<<e.what()<<std::endl;
+        return 1;
+    }
+    return 0;
+}
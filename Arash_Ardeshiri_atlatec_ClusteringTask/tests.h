@@ -0,0 +1,380 @@
+#include "DrillPlanner.h"
+#include "TiledDrillPlanner.h"
+#include "DrillPipeline.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <cstdio>
+#include <set>
+
+namespace
+{
+atlatec_test::GrayImage random_map(size_t h, size_t w, unsigned seed)
+{
+    std::mt19937 gen{seed};
+    std::uniform_int_distribution<int> d{0, 255};
+    atlatec_test::GrayImage img(h, w);
+    for(auto& p : img)
+    {
+        p = static_cast<std::uint8_t>(d(gen));
+    }
+    return img;
+}
+
+///the mask main.py draws, evaluated pixel by pixel
+std::uint64_t brute_disk_sum(const atlatec_test::GrayImage& img, long cx, long cy, long r)
+{
+    std::uint64_t sum = 0;
+    for(long y = 0; y < static_cast<long>(img.rows()); y++)
+    {
+        for(long x = 0; x < static_cast<long>(img.cols()); x++)
+        {
+            if((x-cx)*(x-cx) + (y-cy)*(y-cy) <= r*r)
+            {
+                sum += img.at(y, x);
+            }
+        }
+    }
+    return sum;
+}
+
+std::string write_png(const atlatec_test::GrayImage& img, const std::string& name)
+{
+    const std::string filename = testing::TempDir() + name;
+    png_image png{};
+    png.version = PNG_IMAGE_VERSION;
+    png.width = static_cast<png_uint_32>(img.cols());
+    png.height = static_cast<png_uint_32>(img.rows());
+    png.format = PNG_FORMAT_GRAY;
+    png_image_write_to_file(&png, filename.c_str(), 0, img.begin(), 0, nullptr);
+    return filename;
+}
+
+std::string write_pgm(const atlatec_test::GrayImage& img, const std::string& name, size_t cut = 0)
+{
+    const std::string filename = testing::TempDir() + name;
+    std::ofstream f{filename, std::ios::binary};
+    f<<"P5\n# survey\n"<<img.cols()<<' '<<img.rows()<<"\n255\n";
+    f.write(reinterpret_cast<const char*>(img.begin()), static_cast<std::streamsize>(img.size() - cut));
+    return filename;
+}
+}
+
+TEST(DrillPlannerTest,DiskSum)
+{
+    const auto img = random_map(37, 53, 7);
+    atlatec_test::DrillPlanner planner{img, {6, 4}};
+    for(size_t y = 0; y < img.rows(); y += 3)
+    {
+        for(size_t x = 0; x < img.cols(); x += 2)
+        {
+            EXPECT_EQ(planner.disk_sum(x, y), brute_disk_sum(img, x, y, 6))<<"wrong disk sum at "<<x<<","<<y;
+        }
+    }
+    std::vector<atlatec_test::score_type> row(img.cols());
+    planner.score_row(0, row.data());
+    for(size_t x = 0; x < img.cols(); x++)
+    {
+        EXPECT_EQ(row[x], brute_disk_sum(img, x, 0, 6))<<"wrong row score at "<<x;
+    }
+}
+
+TEST(DrillPlannerTest,ExactArgmax)
+{
+    auto img = random_map(40, 31, 11);
+    atlatec_test::DrillPlanner planner{img, {5, 6}};
+    const auto drills = planner.plan();
+    ASSERT_EQ(drills.size(), 6)<<"wrong number of drills.";
+    for(const auto& d : drills)
+    {
+        std::uint64_t best = 0;
+        size_t bx = 0, by = 0;
+        for(size_t y = 0; y < img.rows(); y++)
+        {
+            for(size_t x = 0; x < img.cols(); x++)
+            {
+                const auto s = brute_disk_sum(img, x, y, 5);
+                if(s > best)
+                {
+                    best = s;
+                    bx = x;
+                    by = y;
+                }
+            }
+        }
+        EXPECT_EQ(d.oil, best)<<"drill is not the true argmax.";
+        EXPECT_EQ(d.x, bx)<<"ties must resolve to the smallest (y, x).";
+        EXPECT_EQ(d.y, by)<<"ties must resolve to the smallest (y, x).";
+        for(size_t y = 0; y < img.rows(); y++)
+        {
+            for(size_t x = 0; x < img.cols(); x++)
+            {
+                if((x-bx)*(x-bx) + (y-by)*(y-by) <= 25)
+                {
+                    img.at(y, x) = 0;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(planner.image(), img)<<"drilled disks must be removed from the map.";
+}
+
+TEST(DrillPlannerTest,IncrementalUpdates)
+{
+    ///many drills on a map spanning several tiles, checked against a full rescan before every drill
+    const auto img = random_map(150, 170, 3);
+    const atlatec_test::DrillSettings settings{4, 300, 3};
+    const auto drills = atlatec_test::DrillPlanner{img, settings}.plan();
+    ASSERT_EQ(drills.size(), settings.drills)<<"wrong number of drills.";
+
+    atlatec_test::DrillPlanner reference{img, settings};
+    for(const auto& d : drills)
+    {
+        atlatec_test::Drill best{0, 0, 0};
+        for(size_t y = 0; y < img.rows(); y++)
+        {
+            for(size_t x = 0; x < img.cols(); x++)
+            {
+                const auto s = reference.disk_sum(x, y);
+                if(s > best.oil)
+                {
+                    best = atlatec_test::Drill{x, y, s};
+                }
+            }
+        }
+        ASSERT_EQ(d.oil, best.oil)<<"incremental score map is out of date.";
+        ASSERT_EQ(d.x, best.x)<<"incremental score map is out of date.";
+        ASSERT_EQ(d.y, best.y)<<"incremental score map is out of date.";
+        reference.drill(d.x, d.y);
+    }
+}
+
+TEST(DrillPlannerTest,ThreadCountIndependent)
+{
+    const auto img = random_map(301, 257, 5);
+    const auto one = atlatec_test::DrillPlanner{img, {25, 64, 1}}.plan();
+    for(size_t threads : {2, 3, 8})
+    {
+        const auto many = atlatec_test::DrillPlanner{img, {25, 64, threads}}.plan();
+        ASSERT_EQ(many.size(), one.size());
+        for(size_t i = 0; i < one.size(); i++)
+        {
+            EXPECT_TRUE(many[i].x == one[i].x && many[i].y == one[i].y && many[i].oil == one[i].oil)<<"plan depends on the thread count.";
+        }
+    }
+}
+
+TEST(DrillPlannerTest,PlanFile)
+{
+    EXPECT_EQ(atlatec_test::plan_filename("./pics/oil1.png"), "./pics/oil1_drilling_plan.txt");
+    EXPECT_EQ(atlatec_test::plan_filename("map"), "map_drilling_plan.txt");
+
+    atlatec_test::GrayImage img(20, 30);
+    img.at(4, 25) = 200;
+    img.at(15, 3) = 100;
+    const auto drills = atlatec_test::DrillPlanner{img, {2, 2}}.plan();
+    const std::string filename = testing::TempDir() + "plan_test_drilling_plan.txt";
+    atlatec_test::write_plan(filename, drills);
+    std::ifstream f{filename};
+    std::stringstream ss;
+    ss<<f.rdbuf();
+    EXPECT_EQ(ss.str(), "25 2\n3 13\n")<<"wrong plan file.";
+    std::remove(filename.c_str());
+}
+
+TEST(DrillPlannerTest,EmptyWindow)
+{
+    atlatec_test::DrillPlanner planner{random_map(20, 20, 31), {3, 4}, atlatec_test::Window{5, 5, 5, 12}};
+    planner.score();
+    EXPECT_TRUE(planner.plan().empty())<<"an empty window has no drills.";
+    EXPECT_THROW(planner.next_drill(), atlatec_test::wrong_input);
+}
+
+TEST(TiledDrillPlannerTest,MappedPgm)
+{
+    const auto img = random_map(23, 41, 13);
+    const std::string filename = write_pgm(img, "mapped_test.pgm");
+    {
+        const auto map = atlatec_test::MappedImage::open_pgm(filename);
+        ASSERT_EQ(map.width(), img.cols());
+        ASSERT_EQ(map.height(), img.rows());
+        EXPECT_EQ(map.at(22, 40), img.at(22, 40));
+        EXPECT_EQ(map.region(0, 0, img.cols(), img.rows()), img)<<"wrong pixels read from the mapping.";
+    }
+    std::remove(filename.c_str());
+
+    const std::string truncated = write_pgm(img, "truncated_test.pgm", 5);
+    EXPECT_THROW(atlatec_test::MappedImage::open_pgm(truncated), atlatec_test::image_error);
+    std::remove(truncated.c_str());
+}
+
+TEST(TiledDrillPlannerTest,SingleTileIsExact)
+{
+    const auto img = random_map(130, 150, 17);
+    const std::string filename = write_pgm(img, "single_tile_test.pgm");
+    const atlatec_test::DrillSettings settings{6, 40, 2};
+    const auto expected = atlatec_test::DrillPlanner{img, settings}.plan();
+    const auto map = atlatec_test::MappedImage::open_pgm(filename);
+    const auto drills = atlatec_test::TiledDrillPlanner{map, settings, {256}}.plan();
+    ASSERT_EQ(drills.size(), expected.size());
+    for(size_t i = 0; i < drills.size(); i++)
+    {
+        EXPECT_TRUE(drills[i].x == expected[i].x && drills[i].y == expected[i].y && drills[i].oil == expected[i].oil)
+            <<"a map that fits into one tile must give the untiled plan.";
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(TiledDrillPlannerTest,SmallTiles)
+{
+    ///drills near tile borders must count the oil of the neighbouring tiles and not drill it twice
+    const auto img = random_map(200, 230, 19);
+    const std::string filename = write_pgm(img, "small_tiles_test.pgm");
+    const atlatec_test::DrillSettings settings{5, 120, 1};
+    const auto map = atlatec_test::MappedImage::open_pgm(filename);
+    atlatec_test::TiledDrillPlanner planner{map, settings, {48}};
+    const auto drills = planner.plan();
+    ASSERT_EQ(drills.size(), settings.drills);
+    EXPECT_LT(planner.peak_tile_bytes(), img.size()*9)<<"a tile must not hold the whole map.";
+
+    atlatec_test::DrillPlanner replay{img, settings};
+    std::uint64_t tiled = 0;
+    for(const auto& d : drills)
+    {
+        ASSERT_EQ(d.oil, replay.disk_sum(d.x, d.y))<<"wrong remaining oil at "<<d.x<<","<<d.y;
+        replay.drill(d.x, d.y);
+        tiled += d.oil;
+    }
+    std::uint64_t exact = 0;
+    for(const auto& d : atlatec_test::DrillPlanner{img, settings}.plan())
+    {
+        exact += d.oil;
+    }
+    EXPECT_GT(tiled, exact*95/100)<<"tiled plan collects far less oil than the untiled one.";
+    std::remove(filename.c_str());
+}
+
+TEST(TiledDrillPlannerTest,ClusteredOil)
+{
+    ///all of the oil sits in one patch, the tiles around it are empty and must not take its drills
+    atlatec_test::GrayImage img(512, 512);
+    const auto patch = random_map(90, 90, 29);
+    for(size_t y = 0; y < patch.rows(); y++)
+    {
+        for(size_t x = 0; x < patch.cols(); x++)
+        {
+            img.at(y + 300, x + 40) = patch.at(y, x);
+        }
+    }
+    const std::string filename = write_pgm(img, "clustered_test.pgm");
+    const atlatec_test::DrillSettings settings{4, 80, 1};
+    const auto map = atlatec_test::MappedImage::open_pgm(filename);
+    std::uint64_t exact = 0, tiled = 0;
+    for(const auto& d : atlatec_test::DrillPlanner{img, settings}.plan())
+    {
+        exact += d.oil;
+    }
+    for(const auto& d : atlatec_test::TiledDrillPlanner{map, settings, {128}}.plan())
+    {
+        tiled += d.oil;
+    }
+    EXPECT_GT(tiled, exact*99/100)<<"tiled plan collects far less oil than the untiled one.";
+
+    ///far more drills than the patch can take, dry tiles must not hand out the same empty center over and over
+    const auto many = atlatec_test::TiledDrillPlanner{map, {4, 2000, 1}, {128}}.plan();
+    std::set<std::pair<size_t, size_t>> centers;
+    for(const auto& d : many)
+    {
+        EXPECT_TRUE(centers.emplace(d.x, d.y).second)<<"center "<<d.x<<","<<d.y<<" drilled twice.";
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(DrillPipelineTest,SameAsSingleMaps)
+{
+    std::vector<atlatec_test::GrayImage> imgs;
+    std::vector<std::string> maps;
+    for(unsigned i = 0; i < 7; i++)
+    {
+        imgs.push_back(random_map(60 + 10*i, 90 - 5*i, 100 + i));
+        maps.push_back(write_png(imgs.back(), "pipeline_test_" + std::to_string(i) + ".png"));
+    }
+    maps.insert(maps.begin() + 3, testing::TempDir() + "pipeline_test_missing.png");
+
+    atlatec_test::BatchSettings settings{};
+    settings.drills = {4, 12, 1};
+    settings.workers = 2;
+    settings.queue = 1; ///every stage runs into backpressure
+    const auto report = atlatec_test::DrillPipeline{settings}.run(maps);
+    ASSERT_EQ(report.maps.size(), maps.size());
+    ASSERT_EQ(report.stages.size(), 4);
+    for(const auto& s : report.stages)
+    {
+        EXPECT_EQ(s.maps, maps.size())<<"stage "<<s.name<<" lost maps.";
+    }
+    EXPECT_FALSE(report.maps[3].error.empty())<<"a missing map must be reported.";
+    EXPECT_EQ(report.planned(), maps.size() - 1)<<"failed maps must not count as planned.";
+    for(size_t i = 0, k = 0; i < maps.size(); i++)
+    {
+        const auto& r = report.maps[i];
+        if(i == 3)
+        {
+            continue;
+        }
+        ASSERT_TRUE(r.error.empty())<<r.error;
+        ASSERT_EQ(r.map, maps[i])<<"results must keep the input order.";
+        const auto expected = atlatec_test::DrillPlanner{imgs[k++], settings.drills}.plan();
+        ASSERT_EQ(r.drills.size(), expected.size());
+        auto written = atlatec_test::read_plan(r.plan);
+        ASSERT_EQ(written.size(), expected.size());
+        for(size_t j = 0; j < expected.size(); j++)
+        {
+            EXPECT_TRUE(r.drills[j].x == expected[j].x && r.drills[j].y == expected[j].y && r.drills[j].oil == expected[j].oil)
+                <<"pipeline plan differs from DrillPlanner.";
+            EXPECT_TRUE(written[j].x == expected[j].x && written[j].y == expected[j].y)<<"wrong plan file.";
+        }
+        std::remove(r.plan.c_str());
+        std::remove(r.map.c_str());
+    }
+}
+
+TEST(DrillPipelineTest,SamePlanPath)
+{
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::path{testing::TempDir()}/"pipeline_dup";
+    fs::create_directories(dir/"a");
+    fs::create_directories(dir/"b");
+    const auto img = random_map(40, 40, 37);
+    const std::string a = write_png(img, "pipeline_dup/a/oil.png"), b = write_png(img, "pipeline_dup/b/oil.png");
+
+    atlatec_test::BatchSettings settings{};
+    settings.drills = {4, 3, 1};
+    settings.workers = 1;
+    settings.output_dir = (dir/"out"/"plans").string(); ///does not exist yet
+    const auto report = atlatec_test::DrillPipeline{settings}.run({a, b, a});
+    EXPECT_TRUE(report.maps[0].error.empty())<<report.maps[0].error;
+    EXPECT_FALSE(report.maps[1].error.empty())<<"two maps must not share one plan file.";
+    EXPECT_TRUE(report.maps[2].error.empty())<<"a map listed twice may write its plan twice.";
+    EXPECT_TRUE(fs::exists(dir/"out"/"plans"/"oil_drilling_plan.txt"))<<"output directory was not created.";
+    fs::remove_all(dir);
+}
+
+TEST(DrillPipelineTest,PlanOil)
+{
+    const auto img = random_map(50, 60, 23);
+    atlatec_test::DrillPlanner planner{img, {5, 9}};
+    auto drills = planner.plan();
+    std::uint64_t total = 0;
+    for(const auto& d : drills)
+    {
+        total += d.oil;
+    }
+    auto replay = drills;
+    EXPECT_EQ(atlatec_test::plan_oil(img, replay, 5), total)<<"replayed plan must reach the planned oil.";
+    for(size_t i = 0; i < drills.size(); i++)
+    {
+        EXPECT_EQ(replay[i].oil, drills[i].oil);
+    }
+    std::vector<atlatec_test::Drill> border{{60, 50, 0}};
+    EXPECT_EQ(atlatec_test::plan_oil(img, border, 5), brute_disk_sum(img, 60, 50, 5))<<"main.py centers on the border are clipped.";
+}
@@ -0,0 +1,406 @@
+#ifndef DYNAMICMATRIX_H
+#define DYNAMICMATRIX_H
+
+#include <iostream>
+#include <valarray>
+#include <iomanip>
+#include <initializer_list>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+#include "Matrix.h"
+#include "Vector.h"
+#include "Kernels.h"
+
+namespace atlatec_test
+{
+
+///same row-major valarray layout as Matrix but the dimensions are chosen at runtime, so both can hand
+///their storage over to each other and every operation below runs on the kernels Matrix uses.
+template<typename T>
+requires number<T>
+class DynamicMatrix
+{
+public:
+    using value_type = T;
+    using container_type = std::valarray<value_type>;
+
+    DynamicMatrix();
+    DynamicMatrix(size_t r, size_t c);
+    DynamicMatrix(std::initializer_list<std::initializer_list<T>> l);
+    DynamicMatrix(size_t r, size_t c, const std::valarray<T>& v);
+    DynamicMatrix(size_t r, size_t c, std::valarray<T>&& v); ///takes over the storage without copying
+    template<size_t m, size_t n>
+    explicit DynamicMatrix(const Matrix<m, n, T>& mtx);
+    template<size_t m, size_t n>
+    explicit DynamicMatrix(Matrix<m, n, T>&& mtx); ///takes over the storage of mtx without copying
+
+    ~DynamicMatrix() = default;
+    DynamicMatrix(const DynamicMatrix&) = default;
+    DynamicMatrix& operator=(const DynamicMatrix&) = default;
+    DynamicMatrix(DynamicMatrix&&) = default;
+    DynamicMatrix& operator=(DynamicMatrix&&) = default;
+
+    size_t rows() const noexcept;
+    size_t cols() const noexcept;
+    size_t size() const noexcept;
+
+    void print() const;
+    const std::valarray<value_type>& underlying_valarray() const noexcept;
+    container_type release() noexcept; ///moves the storage out and leaves a 0x0 matrix
+
+    value_type* begin() noexcept;
+    const value_type* begin() const noexcept;
+    value_type* end() noexcept;
+    const value_type* end() const noexcept;
+
+    value_type& operator[](size_t i); ///to get value directly from underlying valarray
+    const value_type& operator[](size_t i) const;
+    value_type& at (size_t, size_t); ///to get value with x and y
+    const value_type& at (size_t, size_t) const;
+
+private:
+    size_t _rows;
+    size_t _cols;
+    container_type data;
+};
+
+template<typename M>
+struct is_dynamic_matrix : std::false_type {};
+
+template<typename T>
+struct is_dynamic_matrix<DynamicMatrix<T>> : std::true_type {};
+
+template<typename M>
+struct is_static_matrix : std::false_type {};
+
+template<size_t m, size_t n, typename T>
+struct is_static_matrix<Matrix<m, n, T>> : std::true_type {};
+
+template<typename M>
+concept dense_matrix = is_dynamic_matrix<M>::value || is_static_matrix<M>::value;
+
+///at least one operand is a DynamicMatrix, all-static operations keep their compile-time checked overloads.
+template<typename L, typename R>
+concept mixed_matrices = dense_matrix<L> && dense_matrix<R> && (is_dynamic_matrix<L>::value || is_dynamic_matrix<R>::value)
+                         && std::same_as<typename L::value_type, typename R::value_type>;
+
+template<size_t m, size_t n, typename T>
+constexpr size_t rows_of(const Matrix<m, n, T>&) noexcept
+{
+    return m;
+}
+
+template<size_t m, size_t n, typename T>
+constexpr size_t cols_of(const Matrix<m, n, T>&) noexcept
+{
+    return n;
+}
+
+template<typename T>
+size_t rows_of(const DynamicMatrix<T>& mtx) noexcept
+{
+    return mtx.rows();
+}
+
+template<typename T>
+size_t cols_of(const DynamicMatrix<T>& mtx) noexcept
+{
+    return mtx.cols();
+}
+
+template< typename T>
+std::ostream& operator<<(std::ostream& os, const DynamicMatrix<T>& mtx )
+{
+    os<<std::endl;
+    for(size_t i = 0 ; i < mtx.rows(); i++)
+    {
+        for(size_t j = 0 ; j < mtx.cols(); j++)
+        {
+            os<< std::setw(10) <<mtx[i*mtx.cols() + j];
+        }
+        os<<std::endl;
+    }
+    return os;
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::DynamicMatrix():_rows{0}, _cols{0}, data{}
+{}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::DynamicMatrix(size_t r, size_t c):_rows{r}, _cols{c}, data(r*c)
+{}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::DynamicMatrix(std::initializer_list<std::initializer_list<T>> l):_rows{l.size()}, _cols{l.size() ? l.begin()->size() : 0}, data(_rows*_cols)
+{
+    for(auto row : l)
+    {
+        if(_cols != row.size())
+        {
+            throw wrong_input{"wrong input!"};
+        }
+    }
+    size_t i = 0;
+    for(auto row : l)
+    {
+        for(auto item : row)
+        {
+            data[i++] = item;
+        }
+    }
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::DynamicMatrix(size_t r, size_t c, const std::valarray<T>& v):_rows{r}, _cols{c}, data{v}
+{
+    if(_rows*_cols != v.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::DynamicMatrix(size_t r, size_t c, std::valarray<T>&& v):_rows{r}, _cols{c}, data{std::move(v)}
+{
+    if(_rows*_cols != data.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template< typename T>
+requires number<T>
+template<size_t m, size_t n>
+DynamicMatrix<T>::DynamicMatrix(const Matrix<m, n, T>& mtx):_rows{m}, _cols{n}, data{mtx.underlying_valarray()}
+{}
+
+template< typename T>
+requires number<T>
+template<size_t m, size_t n>
+DynamicMatrix<T>::DynamicMatrix(Matrix<m, n, T>&& mtx):_rows{m}, _cols{n}, data{mtx.release()}
+{}
+
+template< typename T>
+requires number<T>
+size_t DynamicMatrix<T>::rows() const noexcept
+{
+    return _rows;
+}
+
+template< typename T>
+requires number<T>
+size_t DynamicMatrix<T>::cols() const noexcept
+{
+    return _cols;
+}
+
+template< typename T>
+requires number<T>
+size_t DynamicMatrix<T>::size() const noexcept
+{
+    return _rows*_cols;
+}
+
+template< typename T>
+requires number<T>
+void DynamicMatrix<T>::print() const
+{
+    for(size_t i = 0 ; i < _rows; i++)
+    {
+        for(size_t j = 0 ; j < _cols; j++)
+        {
+            std::cout<< std::setw(10) <<data[i*_cols + j];
+        }
+        std::cout<<std::endl;
+    }
+}
+
+template< typename T>
+requires number<T>
+const DynamicMatrix<T>::container_type& DynamicMatrix<T>::underlying_valarray() const noexcept
+{
+    return data;
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::container_type DynamicMatrix<T>::release() noexcept
+{
+    _rows = 0;
+    _cols = 0;
+    return std::move(data);
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::value_type* DynamicMatrix<T>::begin() noexcept
+{
+    return std::begin(data);
+}
+
+template< typename T>
+requires number<T>
+const DynamicMatrix<T>::value_type* DynamicMatrix<T>::begin() const noexcept
+{
+    return std::begin(data);
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::value_type* DynamicMatrix<T>::end() noexcept
+{
+    return std::end(data);
+}
+
+template< typename T>
+requires number<T>
+const DynamicMatrix<T>::value_type* DynamicMatrix<T>::end() const noexcept
+{
+    return std::end(data);
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::value_type& DynamicMatrix<T>::operator[](size_t i)
+{
+    return data[i];
+}
+
+template< typename T>
+requires number<T>
+const DynamicMatrix<T>::value_type& DynamicMatrix<T>::operator[](size_t i) const
+{
+    return data[i];
+}
+
+template< typename T>
+requires number<T>
+DynamicMatrix<T>::value_type& DynamicMatrix<T>::at (size_t i, size_t j)
+{
+    if( j >= _cols || i >= _rows)
+    {
+        throw std::out_of_range{"wrong index."};
+    }
+    return data[i*_cols + j];
+}
+
+template< typename T>
+requires number<T>
+const DynamicMatrix<T>::value_type& DynamicMatrix<T>::at (size_t i, size_t j) const
+{
+    if( j >= _cols || i >= _rows)
+    {
+        throw std::out_of_range{"wrong index."};
+    }
+    return data[i*_cols + j];
+}
+
+///hands the storage back to a static Matrix without copying, the dimensions are checked at runtime.
+template<size_t m, size_t n, typename T>
+Matrix<m, n, T> to_matrix(DynamicMatrix<T>&& mtx)
+{
+    if(mtx.rows() != m || mtx.cols() != n)
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    return Matrix<m, n, T>{mtx.release()};
+}
+
+template<typename L, typename R>
+requires mixed_matrices<L, R>
+bool operator==( const L& l, const R& r )
+{
+    using T = typename L::value_type;
+    if(rows_of(l) != rows_of(r) || cols_of(l) != cols_of(r))
+    {
+        return false;
+    }
+    if constexpr( !std::is_floating_point_v<T> )
+    {
+        return std::equal(l.begin(), l.end(), r.begin());
+    }
+    else
+    {
+        const double epsilon = 0.00001; /// same tolerance as the static Matrix comparison
+        return std::equal(l.begin(), l.end(), r.begin(), [epsilon](const T& a, const T& b)
+        {
+            return std::abs(a - b) <= epsilon;
+        });
+    }
+}
+
+template<typename L, typename R>
+requires mixed_matrices<L, R>
+auto operator*( const L& l, const R& r )
+{
+    if(cols_of(l) != rows_of(r))
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    DynamicMatrix<typename L::value_type> res(rows_of(l), cols_of(r));
+    kernels::gemm(rows_of(l), cols_of(r), cols_of(l), l.begin(), cols_of(l), r.begin(), cols_of(r), res.begin(), res.cols());
+    return res;
+}
+
+template<typename L, typename R>
+requires mixed_matrices<L, R>
+auto operator+( const L& l, const R& r )
+{
+    if(rows_of(l) != rows_of(r) || cols_of(l) != cols_of(r))
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    DynamicMatrix<typename L::value_type> res(rows_of(l), cols_of(l));
+    kernels::add(res.size(), l.begin(), r.begin(), res.begin());
+    return res;
+}
+
+template<typename T, typename U>
+requires number<T> && number<U> && std::same_as<T,U>
+auto operator*( U sc, const DynamicMatrix<T>& r )
+{
+    return DynamicMatrix<T> { r.rows(), r.cols(), sc*r.underlying_valarray() };
+}
+
+template<typename T, typename U>
+requires std::same_as<T,U>
+auto operator*( const DynamicMatrix<T>& l, U sc )
+{
+    return sc*l;
+}
+
+template<typename T, typename U>
+requires number<T> && std::same_as<T,U>
+auto operator*( const DynamicMatrix<T>& l_m, const Vector<U>& r_v)
+{
+    if( l_m.cols() != r_v.size() )
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    Vector<T> res(l_m.rows());
+    kernels::gemv(l_m.rows(), l_m.cols(), l_m.begin(), l_m.cols(), r_v.begin(), res.begin());
+    return res;
+}
+
+template<typename T, typename U>
+requires number<T> && std::same_as<T,U>
+auto operator*(const Vector<T>& l_v, const DynamicMatrix<U>& r_m)
+{
+    if( r_m.rows() != l_v.size() )
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    Vector<T> res(r_m.cols());
+    kernels::gevm(r_m.rows(), r_m.cols(), l_v.begin(), r_m.begin(), r_m.cols(), res.begin());
+    return res;
+}
+
+}
+#endif // DYNAMICMATRIX_H
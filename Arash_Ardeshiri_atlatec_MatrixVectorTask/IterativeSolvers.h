@@ -0,0 +1,629 @@
+#ifndef ITERATIVESOLVERS_H
+#define ITERATIVESOLVERS_H
+
+#include <iostream>
+#include <vector>
+#include <valarray>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <type_traits>
+#include "Matrix.h"
+#include "Vector.h"
+#include "DynamicMatrix.h"
+#include "SparseMatrix.h"
+#include "Kernels.h"
+
+namespace atlatec_test
+{
+
+///a linear operator is a dense Matrix/DynamicMatrix, a CsrMatrix, or any callable op(x, y) that writes y = A * x
+///through raw pointers, so matrix-free operators never have to build a Vector per product.
+template<typename Op, typename T>
+concept linear_operator = dense_matrix<Op> || std::same_as<Op, CsrMatrix<T>> || std::invocable<const Op&, const T*, T*>;
+
+///a preconditioner writes z = M^-1 * r, it must not allocate inside apply.
+template<typename P, typename T>
+concept preconditioner = requires(const P& p, const T* r, T* z)
+{
+    p.apply(r, z);
+};
+
+struct SolverSettings
+{
+    double tolerance = 1e-8; ///on the relative residual ||b - A*x|| / ||b||
+    size_t max_iterations = 1000;
+};
+
+struct SolverResult
+{
+    bool converged = false;
+    size_t iterations = 0;
+    double relative_residual = 0;
+    double seconds = 0;
+
+    double iterations_per_second() const noexcept
+    {
+        return seconds > 0 ? iterations/seconds : 0;
+    }
+};
+
+namespace detail
+{
+
+template<typename Op, typename T>
+void apply_operator(const Op& op, const T* x, T* y, size_t n)
+{
+    if constexpr(dense_matrix<Op>)
+    {
+        std::fill(y, y + n, T{});
+        kernels::gemv(rows_of(op), cols_of(op), op.begin(), cols_of(op), x, y);
+    }
+    else if constexpr(std::same_as<Op, CsrMatrix<T>>)
+    {
+        op.multiply(x, y);
+    }
+    else
+    {
+        op(x, y);
+    }
+}
+
+template<typename Op, typename T>
+void check_system(const Op& op, const Vector<T>& b, const Vector<T>& x, size_t n)
+{
+    if(b.size() != n || x.size() != n)
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    if constexpr(dense_matrix<Op>)
+    {
+        if(rows_of(op) != n || cols_of(op) != n)
+        {
+            throw wrong_operand{"operands are inconsistent."};
+        }
+    }
+    else if constexpr(std::same_as<Op, CsrMatrix<T>>)
+    {
+        if(op.rows() != n || op.cols() != n)
+        {
+            throw wrong_operand{"operands are inconsistent."};
+        }
+    }
+}
+
+///r = b - A * x
+template<typename Op, typename T>
+void residual(const Op& op, const T* b, const T* x, T* r, size_t n)
+{
+    apply_operator(op, x, r, n);
+    for(size_t i = 0; i < n; i++)
+    {
+        r[i] = b[i] - r[i];
+    }
+}
+
+template<typename T>
+T norm(const T* x, size_t n)
+{
+    return std::sqrt(kernels::dot(n, x, x));
+}
+
+template<typename T>
+void copy(const T* x, T* y, size_t n)
+{
+    std::copy(x, x + n, y);
+}
+
+}
+
+template<typename T>
+requires std::floating_point<T>
+class IdentityPreconditioner
+{
+public:
+    explicit IdentityPreconditioner(size_t size = 0):n{size} {}
+    void apply(const T* r, T* z) const
+    {
+        std::copy(r, r + n, z);
+    }
+    void resize(size_t size) noexcept
+    {
+        n = size;
+    }
+private:
+    size_t n;
+};
+
+template<typename T>
+requires std::floating_point<T>
+class JacobiPreconditioner
+{
+public:
+    explicit JacobiPreconditioner(const CsrMatrix<T>& a);
+    explicit JacobiPreconditioner(const DynamicMatrix<T>& a);
+    template<size_t m, size_t n>
+    explicit JacobiPreconditioner(const Matrix<m, n, T>& a);
+
+    void apply(const T* r, T* z) const;
+    size_t size() const noexcept;
+
+private:
+    void invert();
+
+    std::vector<T> inv_diag;
+};
+
+///incomplete LU without fill-in, L and U share the sparsity pattern of A and L has a unit diagonal.
+template<typename T>
+requires std::floating_point<T>
+class Ilu0Preconditioner
+{
+public:
+    explicit Ilu0Preconditioner(const CsrMatrix<T>& a);
+
+    void apply(const T* r, T* z) const;
+    size_t size() const noexcept;
+
+private:
+    std::vector<size_t> offsets;
+    std::vector<size_t> columns;
+    std::vector<size_t> diag; ///position of the diagonal entry of every row
+    std::vector<T> lu;
+};
+
+template<typename T>
+requires std::floating_point<T>
+JacobiPreconditioner<T>::JacobiPreconditioner(const CsrMatrix<T>& a):inv_diag{a.diagonal()}
+{
+    invert();
+}
+
+template<typename T>
+requires std::floating_point<T>
+JacobiPreconditioner<T>::JacobiPreconditioner(const DynamicMatrix<T>& a):inv_diag(std::min(a.rows(), a.cols()))
+{
+    for(size_t i = 0; i < inv_diag.size(); i++)
+    {
+        inv_diag[i] = a[i*a.cols() + i];
+    }
+    invert();
+}
+
+template<typename T>
+requires std::floating_point<T>
+template<size_t m, size_t n>
+JacobiPreconditioner<T>::JacobiPreconditioner(const Matrix<m, n, T>& a):inv_diag(std::min(m, n))
+{
+    for(size_t i = 0; i < inv_diag.size(); i++)
+    {
+        inv_diag[i] = a[i*n + i];
+    }
+    invert();
+}
+
+template<typename T>
+requires std::floating_point<T>
+void JacobiPreconditioner<T>::invert()
+{
+    for(auto& d : inv_diag)
+    {
+        if(d == T{})
+        {
+            throw wrong_operand{"zero on the diagonal, jacobi preconditioner is not defined."};
+        }
+        d = T{1}/d;
+    }
+}
+
+template<typename T>
+requires std::floating_point<T>
+size_t JacobiPreconditioner<T>::size() const noexcept
+{
+    return inv_diag.size();
+}
+
+template<typename T>
+requires std::floating_point<T>
+void JacobiPreconditioner<T>::apply(const T* r, T* z) const
+{
+    for(size_t i = 0; i < inv_diag.size(); i++)
+    {
+        z[i] = inv_diag[i]*r[i];
+    }
+}
+
+template<typename T>
+requires std::floating_point<T>
+Ilu0Preconditioner<T>::Ilu0Preconditioner(const CsrMatrix<T>& a):offsets{a.row_offsets()}, columns{a.column_indices()}, diag(a.rows()), lu{a.values()}
+{
+    const size_t n = a.rows();
+    if(a.cols() != n)
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    std::vector<size_t> position(n, size_t(-1)); ///column -> index into the current row
+    for(size_t i = 0; i < n; i++)
+    {
+        for(size_t k = offsets[i]; k < offsets[i+1]; k++)
+        {
+            position[columns[k]] = k;
+        }
+        diag[i] = position[i];
+        if(diag[i] == size_t(-1))
+        {
+            throw wrong_operand{"zero on the diagonal, ilu(0) preconditioner is not defined."};
+        }
+        for(size_t k = offsets[i]; k < offsets[i+1] && columns[k] < i; k++)
+        {
+            const size_t col = columns[k];
+            lu[k] /= lu[diag[col]];
+            for(size_t p = diag[col] + 1; p < offsets[col+1]; p++)
+            {
+                const size_t target = position[columns[p]];
+                if(target != size_t(-1))
+                {
+                    lu[target] -= lu[k]*lu[p];
+                }
+            }
+        }
+        if(lu[diag[i]] == T{})
+        {
+            throw wrong_operand{"zero pivot in ilu(0) factorization."};
+        }
+        for(size_t k = offsets[i]; k < offsets[i+1]; k++)
+        {
+            position[columns[k]] = size_t(-1);
+        }
+    }
+}
+
+template<typename T>
+requires std::floating_point<T>
+size_t Ilu0Preconditioner<T>::size() const noexcept
+{
+    return diag.size();
+}
+
+template<typename T>
+requires std::floating_point<T>
+void Ilu0Preconditioner<T>::apply(const T* r, T* z) const
+{
+    const size_t n = diag.size();
+    for(size_t i = 0; i < n; i++)
+    {
+        T acc = r[i];
+        for(size_t k = offsets[i]; k < diag[i]; k++)
+        {
+            acc -= lu[k]*z[columns[k]];
+        }
+        z[i] = acc;
+    }
+    for(size_t i = n; i-- > 0;)
+    {
+        T acc = z[i];
+        for(size_t k = diag[i] + 1; k < offsets[i+1]; k++)
+        {
+            acc -= lu[k]*z[columns[k]];
+        }
+        z[i] = acc/lu[diag[i]];
+    }
+}
+
+///preconditioned conjugate gradient, A has to be symmetric positive definite.
+///every work vector is allocated by the constructor so repeated solves of the same size never allocate.
+template<typename T>
+requires std::floating_point<T>
+class ConjugateGradient
+{
+public:
+    explicit ConjugateGradient(size_t n);
+
+    template<typename Op, typename P = IdentityPreconditioner<T>>
+    requires linear_operator<Op, T> && preconditioner<P, T>
+    SolverResult solve(const Op& a, const Vector<T>& b, Vector<T>& x, const P& m = P{}, SolverSettings settings = {});
+
+private:
+    size_t n;
+    std::valarray<T> r, z, p, ap;
+};
+
+///preconditioned bi-conjugate gradient stabilized for general non-symmetric systems, right preconditioned.
+template<typename T>
+requires std::floating_point<T>
+class BiCgStab
+{
+public:
+    explicit BiCgStab(size_t n);
+
+    template<typename Op, typename P = IdentityPreconditioner<T>>
+    requires linear_operator<Op, T> && preconditioner<P, T>
+    SolverResult solve(const Op& a, const Vector<T>& b, Vector<T>& x, const P& m = P{}, SolverSettings settings = {});
+
+private:
+    size_t n;
+    std::valarray<T> r, r_hat, p, v, s, t, p_hat, s_hat;
+};
+
+///restarted gmres(m) with modified gram-schmidt and givens rotations, right preconditioned.
+template<typename T>
+requires std::floating_point<T>
+class Gmres
+{
+public:
+    explicit Gmres(size_t n, size_t restart = 30);
+
+    template<typename Op, typename P = IdentityPreconditioner<T>>
+    requires linear_operator<Op, T> && preconditioner<P, T>
+    SolverResult solve(const Op& a, const Vector<T>& b, Vector<T>& x, const P& m = P{}, SolverSettings settings = {});
+
+private:
+    size_t n;
+    size_t restart;
+    std::valarray<T> basis; ///(restart+1) x n krylov vectors, row-major
+    std::valarray<T> h;     ///(restart+1) x restart hessenberg matrix, row-major
+    std::valarray<T> cs, sn, g, y, w, z;
+};
+
+namespace detail
+{
+
+///the identity is sized to the system, any other preconditioner that knows its size has to match it
+template<typename P, typename T>
+const P& with_size(const P& m, size_t n, IdentityPreconditioner<T>& scratch)
+{
+    if constexpr(std::same_as<P, IdentityPreconditioner<T>>)
+    {
+        scratch.resize(n);
+        return scratch;
+    }
+    else
+    {
+        if constexpr(requires{ {m.size()} -> std::convertible_to<size_t>; })
+        {
+            if(m.size() != n)
+            {
+                throw wrong_operand{"operands are inconsistent."};
+            }
+        }
+        return m;
+    }
+}
+
+}
+
+template<typename T>
+requires std::floating_point<T>
+ConjugateGradient<T>::ConjugateGradient(size_t size):n{size}, r(size), z(size), p(size), ap(size)
+{}
+
+template<typename T>
+requires std::floating_point<T>
+template<typename Op, typename P>
+requires linear_operator<Op, T> && preconditioner<P, T>
+SolverResult ConjugateGradient<T>::solve(const Op& a, const Vector<T>& b, Vector<T>& x, const P& precond, SolverSettings settings)
+{
+    const auto start = std::chrono::steady_clock::now();
+    detail::check_system(a, b, x, n);
+    IdentityPreconditioner<T> identity{};
+    const P& m = detail::with_size(precond, n, identity);
+    SolverResult res{};
+    T *rp = std::begin(r), *zp = std::begin(z), *pp = std::begin(p), *app = std::begin(ap), *xp = x.begin();
+    const T b_norm = detail::norm(b.begin(), n);
+    const T scale = b_norm > T{} ? b_norm : T{1};
+
+    detail::residual(a, b.begin(), xp, rp, n);
+    res.relative_residual = detail::norm(rp, n)/scale;
+    m.apply(rp, zp);
+    detail::copy(zp, pp, n);
+    T rz = kernels::dot(n, rp, zp);
+    while(res.relative_residual > settings.tolerance && res.iterations < settings.max_iterations)
+    {
+        detail::apply_operator(a, pp, app, n);
+        const T p_ap = kernels::dot(n, pp, app);
+        if(p_ap == T{})
+        {
+            break;
+        }
+        const T alpha = rz/p_ap;
+        kernels::axpy(n, alpha, pp, xp);
+        kernels::axpy(n, -alpha, app, rp);
+        res.iterations++;
+        res.relative_residual = detail::norm(rp, n)/scale;
+        m.apply(rp, zp);
+        const T rz_new = kernels::dot(n, rp, zp);
+        const T beta = rz_new/rz;
+        rz = rz_new;
+        for(size_t i = 0; i < n; i++)
+        {
+            pp[i] = zp[i] + beta*pp[i];
+        }
+    }
+    res.converged = res.relative_residual <= settings.tolerance;
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return res;
+}
+
+template<typename T>
+requires std::floating_point<T>
+BiCgStab<T>::BiCgStab(size_t size):n{size}, r(size), r_hat(size), p(size), v(size), s(size), t(size), p_hat(size), s_hat(size)
+{}
+
+template<typename T>
+requires std::floating_point<T>
+template<typename Op, typename P>
+requires linear_operator<Op, T> && preconditioner<P, T>
+SolverResult BiCgStab<T>::solve(const Op& a, const Vector<T>& b, Vector<T>& x, const P& precond, SolverSettings settings)
+{
+    const auto start = std::chrono::steady_clock::now();
+    detail::check_system(a, b, x, n);
+    IdentityPreconditioner<T> identity{};
+    const P& m = detail::with_size(precond, n, identity);
+    SolverResult res{};
+    T *rp = std::begin(r), *rhp = std::begin(r_hat), *pp = std::begin(p), *vp = std::begin(v);
+    T *sp = std::begin(s), *tp = std::begin(t), *php = std::begin(p_hat), *shp = std::begin(s_hat), *xp = x.begin();
+    const T b_norm = detail::norm(b.begin(), n);
+    const T scale = b_norm > T{} ? b_norm : T{1};
+
+    detail::residual(a, b.begin(), xp, rp, n);
+    detail::copy(rp, rhp, n);
+    std::fill(pp, pp + n, T{});
+    std::fill(vp, vp + n, T{});
+    T rho{1}, alpha{1}, omega{1};
+    res.relative_residual = detail::norm(rp, n)/scale;
+    while(res.relative_residual > settings.tolerance && res.iterations < settings.max_iterations)
+    {
+        const T rho_new = kernels::dot(n, rhp, rp);
+        if(rho_new == T{} || omega == T{})
+        {
+            break; ///breakdown, a restart from the current x is up to the caller
+        }
+        const T beta = (rho_new/rho)*(alpha/omega);
+        rho = rho_new;
+        for(size_t i = 0; i < n; i++)
+        {
+            pp[i] = rp[i] + beta*(pp[i] - omega*vp[i]);
+        }
+        m.apply(pp, php);
+        detail::apply_operator(a, php, vp, n);
+        const T rv = kernels::dot(n, rhp, vp);
+        if(rv == T{})
+        {
+            break;
+        }
+        alpha = rho/rv;
+        for(size_t i = 0; i < n; i++)
+        {
+            sp[i] = rp[i] - alpha*vp[i];
+        }
+        res.iterations++;
+        const T s_norm = detail::norm(sp, n)/scale;
+        if(s_norm <= settings.tolerance)
+        {
+            kernels::axpy(n, alpha, php, xp);
+            res.relative_residual = s_norm;
+            break;
+        }
+        m.apply(sp, shp);
+        detail::apply_operator(a, shp, tp, n);
+        const T tt = kernels::dot(n, tp, tp);
+        omega = tt > T{} ? kernels::dot(n, tp, sp)/tt : T{};
+        kernels::axpy(n, alpha, php, xp);
+        kernels::axpy(n, omega, shp, xp);
+        for(size_t i = 0; i < n; i++)
+        {
+            rp[i] = sp[i] - omega*tp[i];
+        }
+        res.relative_residual = detail::norm(rp, n)/scale;
+    }
+    res.converged = res.relative_residual <= settings.tolerance;
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return res;
+}
+
+template<typename T>
+requires std::floating_point<T>
+Gmres<T>::Gmres(size_t size, size_t k):n{size}, restart{std::max<size_t>(k, 1)}, basis((restart+1)*size), h((restart+1)*restart),
+    cs(restart), sn(restart), g(restart+1), y(restart), w(size), z(size)
+{}
+
+template<typename T>
+requires std::floating_point<T>
+template<typename Op, typename P>
+requires linear_operator<Op, T> && preconditioner<P, T>
+SolverResult Gmres<T>::solve(const Op& a, const Vector<T>& b, Vector<T>& x, const P& precond, SolverSettings settings)
+{
+    const auto start = std::chrono::steady_clock::now();
+    detail::check_system(a, b, x, n);
+    IdentityPreconditioner<T> identity{};
+    const P& m = detail::with_size(precond, n, identity);
+    SolverResult res{};
+    T *vp = std::begin(basis), *hp = std::begin(h), *wp = std::begin(w), *zp = std::begin(z), *xp = x.begin();
+    const T b_norm = detail::norm(b.begin(), n);
+    const T scale = b_norm > T{} ? b_norm : T{1};
+
+    while(true)
+    {
+        detail::residual(a, b.begin(), xp, vp, n);
+        const T beta = detail::norm(vp, n);
+        res.relative_residual = beta/scale;
+        if(res.relative_residual <= settings.tolerance || res.iterations >= settings.max_iterations)
+        {
+            break;
+        }
+        for(size_t i = 0; i < n; i++)
+        {
+            vp[i] /= beta;
+        }
+        std::fill(std::begin(g), std::end(g), T{});
+        g[0] = beta;
+
+        size_t k = 0;
+        while(k < restart && res.iterations < settings.max_iterations)
+        {
+            T* v_k = vp + k*n;
+            T* v_next = vp + (k+1)*n;
+            m.apply(v_k, zp);
+            detail::apply_operator(a, zp, v_next, n);
+            for(size_t i = 0; i <= k; i++)
+            {
+                const T h_ik = kernels::dot(n, v_next, vp + i*n);
+                hp[i*restart + k] = h_ik;
+                kernels::axpy(n, -h_ik, vp + i*n, v_next);
+            }
+            const T h_next = detail::norm(v_next, n);
+            hp[(k+1)*restart + k] = h_next;
+            if(h_next > T{})
+            {
+                for(size_t i = 0; i < n; i++)
+                {
+                    v_next[i] /= h_next;
+                }
+            }
+            for(size_t i = 0; i < k; i++)
+            {
+                const T h0 = hp[i*restart + k], h1 = hp[(i+1)*restart + k];
+                hp[i*restart + k] = cs[i]*h0 + sn[i]*h1;
+                hp[(i+1)*restart + k] = -sn[i]*h0 + cs[i]*h1;
+            }
+            const T h_kk = hp[k*restart + k];
+            const T denom = std::hypot(h_kk, h_next);
+            cs[k] = denom > T{} ? h_kk/denom : T{1};
+            sn[k] = denom > T{} ? h_next/denom : T{};
+            hp[k*restart + k] = denom;
+            hp[(k+1)*restart + k] = T{};
+            g[k+1] = -sn[k]*g[k];
+            g[k] = cs[k]*g[k];
+            k++;
+            res.iterations++;
+            res.relative_residual = std::abs(g[k])/scale;
+            if(res.relative_residual <= settings.tolerance || h_next == T{})
+            {
+                break;
+            }
+        }
+
+        for(size_t i = k; i-- > 0;)
+        {
+            T acc = g[i];
+            for(size_t j = i + 1; j < k; j++)
+            {
+                acc -= hp[i*restart + j]*y[j];
+            }
+            y[i] = acc/hp[i*restart + i];
+        }
+        std::fill(wp, wp + n, T{});
+        for(size_t i = 0; i < k; i++)
+        {
+            kernels::axpy(n, y[i], vp + i*n, wp);
+        }
+        m.apply(wp, zp);
+        kernels::axpy(n, T{1}, zp, xp);
+    }
+    res.converged = res.relative_residual <= settings.tolerance;
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return res;
+}
+
+}
+#endif // ITERATIVESOLVERS_H
@@ -0,0 +1,111 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include <algorithm>
+
+namespace atlatec_test
+{
+
+namespace kernels
+{
+
+///block edge used by gemm, 64 doubles per row of a block keeps one panel of B inside L1/L2.
+constexpr size_t gemm_block = 64;
+
+///C(m x n) += A(m x k) * B(k x n), every operand is row-major with its own leading dimension.
+///k and n are blocked so a panel of B stays in cache while every row of A is streamed over it,
+///the inner loop walks rows of B and C with unit stride so the compiler can vectorize it.
+template<typename T>
+void gemm(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+{
+    for(size_t kk = 0; kk < k; kk += gemm_block)
+    {
+        const size_t k_end = std::min(kk + gemm_block, k);
+        for(size_t jj = 0; jj < n; jj += gemm_block)
+        {
+            const size_t j_end = std::min(jj + gemm_block, n);
+            for(size_t i = 0; i < m; i++)
+            {
+                T* c_row = c + i*ldc;
+                for(size_t p = kk; p < k_end; p++)
+                {
+                    const T a_ip = a[i*lda + p];
+                    const T* b_row = b + p*ldb;
+                    for(size_t j = jj; j < j_end; j++)
+                    {
+                        c_row[j] += a_ip*b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+///y(m) += A(m x n) * x(n), one unit stride dot product per row of A.
+template<typename T>
+void gemv(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+{
+    for(size_t i = 0; i < m; i++)
+    {
+        const T* a_row = a + i*lda;
+        T acc{};
+        for(size_t j = 0; j < n; j++)
+        {
+            acc += a_row[j]*x[j];
+        }
+        y[i] += acc;
+    }
+}
+
+///y(n) += x(m) * A(m x n), accumulates scaled rows of A instead of walking its columns.
+template<typename T>
+void gevm(size_t m, size_t n, const T* x, const T* a, size_t lda, T* y)
+{
+    for(size_t i = 0; i < m; i++)
+    {
+        const T* a_row = a + i*lda;
+        const T x_i = x[i];
+        for(size_t j = 0; j < n; j++)
+        {
+            y[j] += x_i*a_row[j];
+        }
+    }
+}
+
+///returns x(n) . y(n)
+template<typename T>
+T dot(size_t n, const T* x, const T* y)
+{
+    T acc{};
+    for(size_t i = 0; i < n; i++)
+    {
+        acc += x[i]*y[i];
+    }
+    return acc;
+}
+
+///y(n) += alpha * x(n)
+template<typename T>
+void axpy(size_t n, T alpha, const T* x, T* y)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        y[i] += alpha*x[i];
+    }
+}
+
+///out(n) = a(n) + b(n), out may alias either operand.
+template<typename T>
+void add(size_t n, const T* a, const T* b, T* out)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+}
+
+}
+#endif // KERNELS_H
@@ -7,6 +7,7 @@
 #include <initializer_list>
 #include <type_traits>
 #include <concepts>
+#include "Kernels.h"
 
 namespace atlatec_test
 {
@@ -37,6 +38,7 @@ public:
     Matrix();
     Matrix(std::initializer_list<std::initializer_list<T>> l);
     explicit Matrix(const std::valarray<T>& v);
+    explicit Matrix(std::valarray<T>&& v); ///takes over the storage without copying
 
     ~Matrix() = default;
     Matrix(const Matrix&) = default;
@@ -46,6 +48,12 @@ public:
 
     void print() const;
     const std::valarray<value_type>& underlying_valarray() const noexcept;
+    container_type release() noexcept; ///moves the storage out, the matrix is left like a moved-from one
+
+    value_type* begin() noexcept; ///row-major iteration over the underlying storage
+    const value_type* begin() const noexcept;
+    value_type* end() noexcept;
+    const value_type* end() const noexcept;
 
     value_type& operator[](size_t i); ///to get value directly from underlying valarray
     const value_type& operator[](size_t i) const;
@@ -129,12 +137,51 @@ Matrix<m, n, T>::Matrix(const std::valarray<T>& v):data{v}
     }
 }
 
+template< size_t m, size_t n, typename T>
+Matrix<m, n, T>::Matrix(std::valarray<T>&& v):data{std::move(v)}
+{
+    if(rows*cols != data.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
 template< size_t m, size_t n, typename T>
 const Matrix<m, n, T>::container_type & Matrix<m, n, T>::underlying_valarray() const noexcept
 {
     return data;
 }
 
+template< size_t m, size_t n, typename T>
+Matrix<m, n, T>::container_type Matrix<m, n, T>::release() noexcept
+{
+    return std::move(data);
+}
+
+template< size_t m, size_t n, typename T>
+Matrix<m, n, T>::value_type* Matrix<m, n, T>::begin() noexcept
+{
+    return std::begin(data);
+}
+
+template< size_t m, size_t n, typename T>
+const Matrix<m, n, T>::value_type* Matrix<m, n, T>::begin() const noexcept
+{
+    return std::begin(data);
+}
+
+template< size_t m, size_t n, typename T>
+Matrix<m, n, T>::value_type* Matrix<m, n, T>::end() noexcept
+{
+    return std::end(data);
+}
+
+template< size_t m, size_t n, typename T>
+const Matrix<m, n, T>::value_type* Matrix<m, n, T>::end() const noexcept
+{
+    return std::end(data);
+}
+
 template< size_t m, size_t n, typename T>
 Matrix<m, n, T>::value_type& Matrix<m, n, T>::operator[](size_t i)
 {
@@ -195,15 +242,7 @@ requires productable<m0, n0, m1, n1, T, U>
 auto operator*( const Matrix<m0, n0, T>& l, const Matrix<m1, n1, U>& r )
 {
     Matrix<m0, n1, std::common_type_t<T,U>> res{};
-    for( size_t i = 0 ; i < l.rows; i++)
-    {
-        auto l_row = l.underlying_valarray()[std::slice(i*l.cols, l.cols, 1)];
-        for(size_t j = 0 ; j < r.cols ; j++)
-        {
-            auto r_col = r.underlying_valarray()[std::slice(j, r.rows, r.cols)];
-            res[i*r.cols + j ] = (l_row*r_col).sum();
-        }
-    }
+    kernels::gemm(l.rows, r.cols, l.cols, l.begin(), l.cols, r.begin(), r.cols, res.begin(), res.cols);
     return res;
 }
 
@@ -211,7 +250,9 @@ template<size_t m0, size_t n0, size_t m1, size_t n1, typename T, typename U>
 requires addable<m0, n0, m1, n1, T, U>
 auto operator+( const Matrix<m0, n0, T>& l, const Matrix<m1, n1, U>& r )
 {
-    return Matrix<m0, n0, std::common_type_t<T,U>> { l.underlying_valarray()+r.underlying_valarray() };
+    Matrix<m0, n0, std::common_type_t<T,U>> res{};
+    kernels::add(res.size, l.begin(), r.begin(), res.begin());
+    return res;
 }
 
 template<size_t m, size_t n, typename T, typename U>
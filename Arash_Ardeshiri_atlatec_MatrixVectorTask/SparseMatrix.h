@@ -0,0 +1,207 @@
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <numeric>
+#include "Matrix.h"
+#include "Vector.h"
+#include "DynamicMatrix.h"
+
+namespace atlatec_test
+{
+
+///compressed sparse row matrix, columns are sorted inside every row and duplicates are summed.
+template<typename T>
+requires number<T>
+class CsrMatrix
+{
+public:
+    using value_type = T;
+    using triplet = std::tuple<size_t, size_t, T>; ///row, column, value
+
+    CsrMatrix(size_t r, size_t c, std::vector<triplet> entries);
+    explicit CsrMatrix(const DynamicMatrix<T>& mtx); ///keeps the non-zero entries
+    template<size_t m, size_t n>
+    explicit CsrMatrix(const Matrix<m, n, T>& mtx);
+
+    ~CsrMatrix() = default;
+    CsrMatrix(const CsrMatrix&) = default;
+    CsrMatrix& operator=(const CsrMatrix&) = default;
+    CsrMatrix(CsrMatrix&&) = default;
+    CsrMatrix& operator=(CsrMatrix&&) = default;
+
+    size_t rows() const noexcept;
+    size_t cols() const noexcept;
+    size_t non_zeros() const noexcept;
+
+    const std::vector<size_t>& row_offsets() const noexcept;
+    const std::vector<size_t>& column_indices() const noexcept;
+    const std::vector<T>& values() const noexcept;
+
+    void multiply(const T* x, T* y) const; ///y = A * x, y must not alias x
+    std::vector<T> diagonal() const;
+
+private:
+    void from_dense(const T* p);
+
+    size_t _rows;
+    size_t _cols;
+    std::vector<size_t> offsets;
+    std::vector<size_t> columns;
+    std::vector<T> entries;
+};
+
+template<typename T>
+requires number<T>
+CsrMatrix<T>::CsrMatrix(size_t r, size_t c, std::vector<triplet> l):_rows{r}, _cols{c}, offsets(r+1, 0), columns{}, entries{}
+{
+    std::sort(l.begin(), l.end(), [](const triplet& a, const triplet& b)
+    {
+        return std::tie(std::get<0>(a), std::get<1>(a)) < std::tie(std::get<0>(b), std::get<1>(b));
+    });
+    columns.reserve(l.size());
+    entries.reserve(l.size());
+    for(size_t i = 0; i < l.size(); i++)
+    {
+        const auto& [row, col, v] = l[i];
+        if(row >= _rows || col >= _cols)
+        {
+            throw wrong_input{"wrong input!"};
+        }
+        if(i > 0 && std::get<0>(l[i-1]) == row && std::get<1>(l[i-1]) == col)
+        {
+            entries.back() += v;
+            continue;
+        }
+        columns.push_back(col);
+        entries.push_back(v);
+        offsets[row+1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+}
+
+template<typename T>
+requires number<T>
+CsrMatrix<T>::CsrMatrix(const DynamicMatrix<T>& mtx):_rows{mtx.rows()}, _cols{mtx.cols()}, offsets(_rows+1, 0), columns{}, entries{}
+{
+    from_dense(mtx.begin());
+}
+
+template<typename T>
+requires number<T>
+template<size_t m, size_t n>
+CsrMatrix<T>::CsrMatrix(const Matrix<m, n, T>& mtx):_rows{m}, _cols{n}, offsets(_rows+1, 0), columns{}, entries{}
+{
+    from_dense(mtx.begin());
+}
+
+template<typename T>
+requires number<T>
+void CsrMatrix<T>::from_dense(const T* p)
+{
+    for(size_t i = 0; i < _rows; i++)
+    {
+        for(size_t j = 0; j < _cols; j++)
+        {
+            if(p[i*_cols + j] != T{})
+            {
+                columns.push_back(j);
+                entries.push_back(p[i*_cols + j]);
+            }
+        }
+        offsets[i+1] = columns.size();
+    }
+}
+
+template<typename T>
+requires number<T>
+size_t CsrMatrix<T>::rows() const noexcept
+{
+    return _rows;
+}
+
+template<typename T>
+requires number<T>
+size_t CsrMatrix<T>::cols() const noexcept
+{
+    return _cols;
+}
+
+template<typename T>
+requires number<T>
+size_t CsrMatrix<T>::non_zeros() const noexcept
+{
+    return entries.size();
+}
+
+template<typename T>
+requires number<T>
+const std::vector<size_t>& CsrMatrix<T>::row_offsets() const noexcept
+{
+    return offsets;
+}
+
+template<typename T>
+requires number<T>
+const std::vector<size_t>& CsrMatrix<T>::column_indices() const noexcept
+{
+    return columns;
+}
+
+template<typename T>
+requires number<T>
+const std::vector<T>& CsrMatrix<T>::values() const noexcept
+{
+    return entries;
+}
+
+template<typename T>
+requires number<T>
+void CsrMatrix<T>::multiply(const T* x, T* y) const
+{
+    for(size_t i = 0; i < _rows; i++)
+    {
+        T acc{};
+        for(size_t k = offsets[i]; k < offsets[i+1]; k++)
+        {
+            acc += entries[k]*x[columns[k]];
+        }
+        y[i] = acc;
+    }
+}
+
+template<typename T>
+requires number<T>
+std::vector<T> CsrMatrix<T>::diagonal() const
+{
+    std::vector<T> res(std::min(_rows, _cols), T{});
+    for(size_t i = 0; i < res.size(); i++)
+    {
+        auto first = columns.begin() + offsets[i], last = columns.begin() + offsets[i+1];
+        auto it = std::lower_bound(first, last, i);
+        if(it != last && *it == i)
+        {
+            res[i] = entries[it - columns.begin()];
+        }
+    }
+    return res;
+}
+
+template<typename T, typename U>
+requires number<T> && std::same_as<T,U>
+auto operator*( const CsrMatrix<T>& l_m, const Vector<U>& r_v)
+{
+    if( l_m.cols() != r_v.size() )
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    Vector<T> res(l_m.rows());
+    l_m.multiply(r_v.begin(), res.begin());
+    return res;
+}
+
+}
+#endif // SPARSEMATRIX_H
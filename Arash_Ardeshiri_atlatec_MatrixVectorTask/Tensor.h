@@ -0,0 +1,909 @@
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include <iostream>
+#include <valarray>
+#include <vector>
+#include <array>
+#include <string>
+#include <string_view>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <concepts>
+#include <optional>
+#include <utility>
+#include <cctype>
+#include "Matrix.h"
+#include "Vector.h"
+#include "DynamicMatrix.h"
+#include "Kernels.h"
+
+namespace atlatec_test
+{
+
+using shape_type = std::vector<size_t>;
+
+inline size_t shape_size(const shape_type& shape) noexcept
+{
+    return std::accumulate(shape.begin(), shape.end(), size_t{1}, std::multiplies<size_t>{});
+}
+
+inline shape_type row_major_strides(const shape_type& shape)
+{
+    shape_type strides(shape.size());
+    size_t s = 1;
+    for(size_t i = shape.size(); i-- > 0;)
+    {
+        strides[i] = s;
+        s *= shape[i];
+    }
+    return strides;
+}
+
+///non-owning, strided view over any storage, strides are counted in elements.
+///reshape and permute only build a new view, the data is never touched.
+template<typename T>
+requires number<T>
+class TensorView
+{
+public:
+    using value_type = T;
+
+    TensorView(T* p, shape_type shape); ///contiguous row-major view
+    TensorView(T* p, shape_type shape, shape_type strides);
+
+    ~TensorView() = default;
+    TensorView(const TensorView&) = default;
+    TensorView& operator=(const TensorView&) = default;
+    TensorView(TensorView&&) = default;
+    TensorView& operator=(TensorView&&) = default;
+
+    operator TensorView<const T>() const requires (!std::is_const_v<T>);
+
+    size_t rank() const noexcept;
+    size_t size() const noexcept;
+    const shape_type& shape() const noexcept;
+    const shape_type& strides() const noexcept;
+    bool is_contiguous() const noexcept;
+    T* data() const noexcept;
+
+    T& operator()(const shape_type& idx) const; ///no bound checks
+    T& at(const shape_type& idx) const;
+
+    TensorView reshape(const shape_type& shape) const;
+    TensorView permute(const std::vector<size_t>& axes) const;
+    TensorView diagonal(size_t axis0, size_t axis1) const; ///merges two equally sized axes into axis0
+
+private:
+    T* ptr;
+    shape_type _shape;
+    shape_type _strides;
+};
+
+///owning tensor whose rank and extents are only known at runtime, always contiguous row-major.
+template<typename T>
+requires number<T>
+class DynamicTensor
+{
+public:
+    using value_type = T;
+    using container_type = std::valarray<value_type>;
+
+    explicit DynamicTensor(shape_type shape);
+    DynamicTensor(shape_type shape, const std::valarray<T>& v);
+    DynamicTensor(shape_type shape, std::valarray<T>&& v);
+    explicit DynamicTensor(TensorView<const T> v); ///copies a possibly strided view into own storage
+
+    ~DynamicTensor() = default;
+    DynamicTensor(const DynamicTensor&) = default;
+    DynamicTensor& operator=(const DynamicTensor&) = default;
+    DynamicTensor(DynamicTensor&&) = default;
+    DynamicTensor& operator=(DynamicTensor&&) = default;
+
+    size_t rank() const noexcept;
+    size_t size() const noexcept;
+    const shape_type& shape() const noexcept;
+    const std::valarray<value_type>& underlying_valarray() const noexcept;
+    container_type release() noexcept;
+
+    TensorView<T> view() noexcept;
+    TensorView<const T> view() const noexcept;
+
+    value_type& operator[](size_t i);
+    const value_type& operator[](size_t i) const;
+    value_type& at(const shape_type& idx);
+    const value_type& at(const shape_type& idx) const;
+
+    void reshape(const shape_type& shape); ///zero-copy, only the extents change
+
+private:
+    shape_type _shape;
+    container_type data;
+};
+
+///owning tensor with compile-time extents, the n-dimensional counterpart of Matrix.
+template<typename T, size_t... dims>
+requires number<T>
+class Tensor
+{
+public:
+    using value_type = T;
+    using container_type = std::valarray<value_type>;
+    static constexpr size_t rank = sizeof...(dims);
+    static constexpr size_t size = (size_t{1} * ... * dims);
+    static constexpr std::array<size_t, rank> shape{dims...};
+
+    Tensor();
+    explicit Tensor(const std::valarray<T>& v);
+    explicit Tensor(std::valarray<T>&& v);
+
+    ~Tensor() = default;
+    Tensor(const Tensor&) = default;
+    Tensor& operator=(const Tensor&) = default;
+    Tensor(Tensor&&) = default;
+    Tensor& operator=(Tensor&&) = default;
+
+    const std::valarray<value_type>& underlying_valarray() const noexcept;
+    container_type release() noexcept;
+
+    TensorView<T> view();
+    TensorView<const T> view() const;
+
+    template<typename... I>
+    requires (sizeof...(I) == rank) && (std::convertible_to<I, size_t> && ...)
+    value_type& operator()(I... idx)
+    {
+        return data[offset(idx...)];
+    }
+    template<typename... I>
+    requires (sizeof...(I) == rank) && (std::convertible_to<I, size_t> && ...)
+    const value_type& operator()(I... idx) const
+    {
+        return data[offset(idx...)];
+    }
+
+    template<size_t... new_dims>
+    requires ((size_t{1} * ... * new_dims) == size)
+    Tensor<T, new_dims...> reshape() && ///moves the storage into the new shape
+    {
+        return Tensor<T, new_dims...>{std::move(data)};
+    }
+
+private:
+    template<typename... I>
+    static size_t offset(I... idx);
+
+    container_type data;
+};
+
+template<typename T>
+requires number<T>
+TensorView<T>::TensorView(T* p, shape_type shape):ptr{p}, _shape{std::move(shape)}, _strides{row_major_strides(_shape)}
+{}
+
+template<typename T>
+requires number<T>
+TensorView<T>::TensorView(T* p, shape_type shape, shape_type strides):ptr{p}, _shape{std::move(shape)}, _strides{std::move(strides)}
+{
+    if(_shape.size() != _strides.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template<typename T>
+requires number<T>
+TensorView<T>::operator TensorView<const T>() const requires (!std::is_const_v<T>)
+{
+    return TensorView<const T>{ptr, _shape, _strides};
+}
+
+template<typename T>
+requires number<T>
+size_t TensorView<T>::rank() const noexcept
+{
+    return _shape.size();
+}
+
+template<typename T>
+requires number<T>
+size_t TensorView<T>::size() const noexcept
+{
+    return shape_size(_shape);
+}
+
+template<typename T>
+requires number<T>
+const shape_type& TensorView<T>::shape() const noexcept
+{
+    return _shape;
+}
+
+template<typename T>
+requires number<T>
+const shape_type& TensorView<T>::strides() const noexcept
+{
+    return _strides;
+}
+
+template<typename T>
+requires number<T>
+bool TensorView<T>::is_contiguous() const noexcept
+{
+    size_t s = 1;
+    for(size_t i = _shape.size(); i-- > 0;)
+    {
+        if(_shape[i] != 1 && _strides[i] != s)
+        {
+            return false;
+        }
+        s *= _shape[i];
+    }
+    return true;
+}
+
+template<typename T>
+requires number<T>
+T* TensorView<T>::data() const noexcept
+{
+    return ptr;
+}
+
+template<typename T>
+requires number<T>
+T& TensorView<T>::operator()(const shape_type& idx) const
+{
+    size_t off = 0;
+    for(size_t i = 0; i < idx.size(); i++)
+    {
+        off += idx[i]*_strides[i];
+    }
+    return ptr[off];
+}
+
+template<typename T>
+requires number<T>
+T& TensorView<T>::at(const shape_type& idx) const
+{
+    if(idx.size() != _shape.size())
+    {
+        throw std::out_of_range{"wrong index."};
+    }
+    for(size_t i = 0; i < idx.size(); i++)
+    {
+        if(idx[i] >= _shape[i])
+        {
+            throw std::out_of_range{"wrong index."};
+        }
+    }
+    return (*this)(idx);
+}
+
+template<typename T>
+requires number<T>
+TensorView<T> TensorView<T>::reshape(const shape_type& shape) const
+{
+    if(shape_size(shape) != size())
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    if(!is_contiguous())
+    {
+        throw wrong_operand{"only contiguous views can be reshaped without a copy."};
+    }
+    return TensorView{ptr, shape};
+}
+
+template<typename T>
+requires number<T>
+TensorView<T> TensorView<T>::permute(const std::vector<size_t>& axes) const
+{
+    if(axes.size() != rank())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+    std::vector<bool> seen(rank(), false);
+    shape_type shape(rank()), strides(rank());
+    for(size_t i = 0; i < axes.size(); i++)
+    {
+        if(axes[i] >= rank() || seen[axes[i]])
+        {
+            throw wrong_input{"wrong input!"};
+        }
+        seen[axes[i]] = true;
+        shape[i] = _shape[axes[i]];
+        strides[i] = _strides[axes[i]];
+    }
+    return TensorView{ptr, std::move(shape), std::move(strides)};
+}
+
+template<typename T>
+requires number<T>
+TensorView<T> TensorView<T>::diagonal(size_t axis0, size_t axis1) const
+{
+    if(axis0 >= rank() || axis1 >= rank() || axis0 == axis1 || _shape[axis0] != _shape[axis1])
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    shape_type shape = _shape, strides = _strides;
+    strides[axis0] += strides[axis1];
+    shape.erase(shape.begin() + axis1);
+    strides.erase(strides.begin() + axis1);
+    return TensorView{ptr, std::move(shape), std::move(strides)};
+}
+
+namespace detail
+{
+
+///calls f(source offset, destination offset) for every index of shape. the axes are visited so that the one
+///with the smallest source stride is innermost, which keeps the reads sequential for permuted views.
+template<typename F>
+void for_each_offset(const shape_type& shape, const shape_type& src_strides, const shape_type& dst_strides, F&& f)
+{
+    const size_t rank = shape.size();
+    if(shape_size(shape) == 0)
+    {
+        return;
+    }
+    std::vector<size_t> order(rank);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        return src_strides[a] > src_strides[b];
+    });
+    shape_type idx(rank, 0);
+    size_t src = 0, dst = 0;
+    const size_t inner = rank ? order[rank-1] : 0;
+    const size_t inner_n = rank ? shape[inner] : 1;
+    const size_t inner_src = rank ? src_strides[inner] : 0;
+    const size_t inner_dst = rank ? dst_strides[inner] : 0;
+    while(true)
+    {
+        for(size_t i = 0; i < inner_n; i++)
+        {
+            f(src + i*inner_src, dst + i*inner_dst);
+        }
+        size_t level = rank > 0 ? rank - 1 : 0;
+        while(level-- > 0)
+        {
+            const size_t ax = order[level];
+            src += src_strides[ax];
+            dst += dst_strides[ax];
+            if(++idx[ax] < shape[ax])
+            {
+                break;
+            }
+            src -= idx[ax]*src_strides[ax];
+            dst -= idx[ax]*dst_strides[ax];
+            idx[ax] = 0;
+        }
+        if(level == size_t(-1))
+        {
+            return;
+        }
+    }
+}
+
+}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::DynamicTensor(shape_type shape):_shape{std::move(shape)}, data(shape_size(_shape))
+{}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::DynamicTensor(shape_type shape, const std::valarray<T>& v):_shape{std::move(shape)}, data{v}
+{
+    if(shape_size(_shape) != data.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::DynamicTensor(shape_type shape, std::valarray<T>&& v):_shape{std::move(shape)}, data{std::move(v)}
+{
+    if(shape_size(_shape) != data.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::DynamicTensor(TensorView<const T> v):_shape{v.shape()}, data(v.size())
+{
+    const T* src = v.data();
+    T* dst = std::begin(data);
+    detail::for_each_offset(_shape, v.strides(), row_major_strides(_shape), [src, dst](size_t s, size_t d)
+    {
+        dst[d] = src[s];
+    });
+}
+
+template<typename T>
+requires number<T>
+size_t DynamicTensor<T>::rank() const noexcept
+{
+    return _shape.size();
+}
+
+template<typename T>
+requires number<T>
+size_t DynamicTensor<T>::size() const noexcept
+{
+    return data.size();
+}
+
+template<typename T>
+requires number<T>
+const shape_type& DynamicTensor<T>::shape() const noexcept
+{
+    return _shape;
+}
+
+template<typename T>
+requires number<T>
+const std::valarray<T>& DynamicTensor<T>::underlying_valarray() const noexcept
+{
+    return data;
+}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::container_type DynamicTensor<T>::release() noexcept
+{
+    _shape = shape_type{0};
+    return std::move(data);
+}
+
+template<typename T>
+requires number<T>
+TensorView<T> DynamicTensor<T>::view() noexcept
+{
+    return TensorView<T>{std::begin(data), _shape};
+}
+
+template<typename T>
+requires number<T>
+TensorView<const T> DynamicTensor<T>::view() const noexcept
+{
+    return TensorView<const T>{std::begin(data), _shape};
+}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::value_type& DynamicTensor<T>::operator[](size_t i)
+{
+    return data[i];
+}
+
+template<typename T>
+requires number<T>
+const DynamicTensor<T>::value_type& DynamicTensor<T>::operator[](size_t i) const
+{
+    return data[i];
+}
+
+template<typename T>
+requires number<T>
+DynamicTensor<T>::value_type& DynamicTensor<T>::at(const shape_type& idx)
+{
+    return view().at(idx);
+}
+
+template<typename T>
+requires number<T>
+const DynamicTensor<T>::value_type& DynamicTensor<T>::at(const shape_type& idx) const
+{
+    return view().at(idx);
+}
+
+template<typename T>
+requires number<T>
+void DynamicTensor<T>::reshape(const shape_type& shape)
+{
+    if(shape_size(shape) != data.size())
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    _shape = shape;
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+Tensor<T, dims...>::Tensor():data(size)
+{}
+
+template<typename T, size_t... dims>
+requires number<T>
+Tensor<T, dims...>::Tensor(const std::valarray<T>& v):data{v}
+{
+    if(size != v.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+Tensor<T, dims...>::Tensor(std::valarray<T>&& v):data{std::move(v)}
+{
+    if(size != data.size())
+    {
+        throw wrong_input{"wrong input!"};
+    }
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+const std::valarray<T>& Tensor<T, dims...>::underlying_valarray() const noexcept
+{
+    return data;
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+Tensor<T, dims...>::container_type Tensor<T, dims...>::release() noexcept
+{
+    return std::move(data);
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+TensorView<T> Tensor<T, dims...>::view()
+{
+    return TensorView<T>{std::begin(data), shape_type{dims...}};
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+TensorView<const T> Tensor<T, dims...>::view() const
+{
+    return TensorView<const T>{std::begin(data), shape_type{dims...}};
+}
+
+template<typename T, size_t... dims>
+requires number<T>
+template<typename... I>
+size_t Tensor<T, dims...>::offset(I... idx)
+{
+    size_t off = 0;
+    ((off = off*dims + static_cast<size_t>(idx)), ...);
+    return off;
+}
+
+///conversions between Matrix/Vector and tensors, views alias the storage and the rvalue overloads move it.
+template<size_t m, size_t n, typename T>
+TensorView<T> as_tensor(Matrix<m, n, T>& mtx)
+{
+    return TensorView<T>{mtx.begin(), shape_type{m, n}};
+}
+
+template<size_t m, size_t n, typename T>
+TensorView<const T> as_tensor(const Matrix<m, n, T>& mtx)
+{
+    return TensorView<const T>{mtx.begin(), shape_type{m, n}};
+}
+
+template<typename T>
+TensorView<T> as_tensor(Vector<T>& vec)
+{
+    return TensorView<T>{vec.begin(), shape_type{vec.size()}};
+}
+
+template<typename T>
+TensorView<const T> as_tensor(const Vector<T>& vec)
+{
+    return TensorView<const T>{vec.begin(), shape_type{vec.size()}};
+}
+
+template<typename T>
+TensorView<T> as_tensor(DynamicMatrix<T>& mtx)
+{
+    return TensorView<T>{mtx.begin(), shape_type{mtx.rows(), mtx.cols()}};
+}
+
+template<typename T>
+TensorView<const T> as_tensor(const DynamicMatrix<T>& mtx)
+{
+    return TensorView<const T>{mtx.begin(), shape_type{mtx.rows(), mtx.cols()}};
+}
+
+template<size_t m, size_t n, typename T>
+Tensor<T, m, n> to_tensor(Matrix<m, n, T>&& mtx)
+{
+    return Tensor<T, m, n>{mtx.release()};
+}
+
+template<typename T>
+DynamicTensor<T> to_tensor(Vector<T>&& vec)
+{
+    const size_t s = vec.size();
+    return DynamicTensor<T>{shape_type{s}, vec.release()};
+}
+
+template<size_t m, size_t n, typename T>
+Matrix<m, n, T> to_matrix(Tensor<T, m, n>&& t)
+{
+    return Matrix<m, n, T>{t.release()};
+}
+
+template<size_t m, size_t n, typename T>
+Matrix<m, n, T> to_matrix(DynamicTensor<T>&& t)
+{
+    if(t.shape() != shape_type{m, n})
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    return Matrix<m, n, T>{t.release()};
+}
+
+template<typename T>
+Vector<T> to_vector(DynamicTensor<T>&& t)
+{
+    if(t.rank() != 1)
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    return Vector<T>{t.release()};
+}
+
+namespace detail
+{
+
+struct einsum_spec
+{
+    std::vector<std::string> inputs;
+    std::string output;
+};
+
+inline einsum_spec parse_einsum(std::string_view spec, size_t operands)
+{
+    std::string s;
+    for(char c : spec)
+    {
+        if(c != ' ')
+        {
+            s.push_back(c);
+        }
+    }
+    const size_t arrow = s.find("->");
+    if(arrow == std::string::npos)
+    {
+        throw wrong_input{"einsum needs an explicit output, e.g. \"ij,jk->ik\"."};
+    }
+    einsum_spec res{};
+    res.output = s.substr(arrow + 2);
+    std::string lhs = s.substr(0, arrow);
+    size_t start = 0;
+    while(true)
+    {
+        const size_t comma = lhs.find(',', start);
+        res.inputs.push_back(lhs.substr(start, comma - start));
+        if(comma == std::string::npos)
+        {
+            break;
+        }
+        start = comma + 1;
+    }
+    if(res.inputs.size() != operands)
+    {
+        throw wrong_input{"wrong input!"};
+    }
+    for(size_t i = 0; i < res.output.size(); i++)
+    {
+        const char c = res.output[i];
+        const bool in_input = std::any_of(res.inputs.begin(), res.inputs.end(), [c](const std::string& in)
+        {
+            return in.find(c) != std::string::npos;
+        });
+        if(!std::isalpha(static_cast<unsigned char>(c)) || res.output.find(c) != i || !in_input)
+        {
+            throw wrong_input{"wrong input!"};
+        }
+    }
+    for(const auto& in : res.inputs)
+    {
+        if(!std::all_of(in.begin(), in.end(), [](char c){ return std::isalpha(static_cast<unsigned char>(c)); }))
+        {
+            throw wrong_input{"wrong input!"};
+        }
+    }
+    return res;
+}
+
+///folds repeated labels of one operand into diagonal views, "ii" becomes "i" without a copy.
+template<typename T>
+TensorView<const T> take_diagonals(TensorView<const T> v, std::string& labels)
+{
+    if(labels.size() != v.rank())
+    {
+        throw wrong_operand{"operands are inconsistent."};
+    }
+    for(size_t i = 0; i < labels.size(); i++)
+    {
+        size_t j;
+        while((j = labels.find(labels[i], i + 1)) != std::string::npos)
+        {
+            v = v.diagonal(i, j);
+            labels.erase(j, 1);
+        }
+    }
+    return v;
+}
+
+///sums over every axis whose label is not in keep, the kept axes stay in their original order.
+template<typename T>
+DynamicTensor<T> sum_out(TensorView<const T> v, std::string& labels, const std::string& keep)
+{
+    shape_type shape, dst_strides(v.rank(), 0);
+    std::string kept;
+    for(size_t i = 0; i < labels.size(); i++)
+    {
+        if(keep.find(labels[i]) != std::string::npos)
+        {
+            shape.push_back(v.shape()[i]);
+            kept.push_back(labels[i]);
+        }
+    }
+    DynamicTensor<T> res{shape};
+    const shape_type strides = row_major_strides(shape);
+    for(size_t i = 0, k = 0; i < labels.size(); i++)
+    {
+        if(keep.find(labels[i]) != std::string::npos)
+        {
+            dst_strides[i] = strides[k++];
+        }
+    }
+    const T* src = v.data();
+    T* dst = res.view().data();
+    for_each_offset(v.shape(), v.strides(), dst_strides, [src, dst](size_t s, size_t d)
+    {
+        dst[d] += src[s];
+    });
+    labels = kept;
+    return res;
+}
+
+///returns the view permuted to the label order wanted, packed into buffer unless it is already contiguous.
+template<typename T>
+const T* pack(TensorView<const T> v, const std::string& labels, const std::string& wanted, std::valarray<T>& buffer)
+{
+    std::vector<size_t> axes;
+    for(char c : wanted)
+    {
+        axes.push_back(labels.find(c));
+    }
+    TensorView<const T> p = v.permute(axes);
+    if(p.is_contiguous())
+    {
+        return p.data();
+    }
+    buffer.resize(p.size());
+    const T* src = p.data();
+    T* dst = std::begin(buffer);
+    for_each_offset(p.shape(), p.strides(), row_major_strides(p.shape()), [src, dst](size_t s, size_t d)
+    {
+        dst[d] = src[s];
+    });
+    return dst;
+}
+
+template<typename T>
+DynamicTensor<T> permute_to(DynamicTensor<T>&& t, const std::string& labels, const std::string& wanted)
+{
+    if(labels == wanted)
+    {
+        return std::move(t);
+    }
+    std::vector<size_t> axes;
+    for(char c : wanted)
+    {
+        axes.push_back(labels.find(c));
+    }
+    return DynamicTensor<T>{std::as_const(t).view().permute(axes)};
+}
+
+}
+
+///single operand einsum: transposes, traces, diagonals and sums, e.g. "ii->", "ijk->kj".
+template<typename T>
+requires number<T>
+auto einsum(std::string_view spec, TensorView<T> a)
+{
+    using V = std::remove_const_t<T>;
+    detail::einsum_spec s = detail::parse_einsum(spec, 1);
+    TensorView<const V> av = detail::take_diagonals<V>(a, s.inputs[0]);
+    DynamicTensor<V> reduced = detail::sum_out<V>(av, s.inputs[0], s.output);
+    return detail::permute_to(std::move(reduced), s.inputs[0], s.output);
+}
+
+///two operand einsum. repeated labels become diagonal views and labels that appear in only one operand
+///and not in the output are summed first, what is left is always a batched GEMM:
+///A[batch, free_a, contracted] * B[batch, contracted, free_b], which runs on kernels::gemm.
+template<typename T, typename U>
+requires number<T> && std::same_as<std::remove_const_t<T>, std::remove_const_t<U>>
+auto einsum(std::string_view spec, TensorView<T> a, TensorView<U> b)
+{
+    using V = std::remove_const_t<T>;
+    detail::einsum_spec s = detail::parse_einsum(spec, 2);
+    std::string& la = s.inputs[0];
+    std::string& lb = s.inputs[1];
+    TensorView<const V> av = detail::take_diagonals<V>(a, la);
+    TensorView<const V> bv = detail::take_diagonals<V>(b, lb);
+
+    std::optional<DynamicTensor<V>> a_reduced, b_reduced;
+    const std::string a_keep = s.output + lb, b_keep = s.output + la;
+    if(std::any_of(la.begin(), la.end(), [&](char c){ return a_keep.find(c) == std::string::npos; }))
+    {
+        a_reduced.emplace(detail::sum_out<V>(av, la, a_keep));
+        av = std::as_const(*a_reduced).view();
+    }
+    if(std::any_of(lb.begin(), lb.end(), [&](char c){ return b_keep.find(c) == std::string::npos; }))
+    {
+        b_reduced.emplace(detail::sum_out<V>(bv, lb, b_keep));
+        bv = std::as_const(*b_reduced).view();
+    }
+
+    std::string batch, free_a, free_b, contracted;
+    shape_type out_shape;
+    size_t nb = 1, m = 1, n = 1, k = 1;
+    for(size_t i = 0; i < la.size(); i++)
+    {
+        const char c = la[i];
+        const size_t j = lb.find(c);
+        const bool in_out = s.output.find(c) != std::string::npos;
+        if(j != std::string::npos && bv.shape()[j] != av.shape()[i])
+        {
+            throw wrong_operand{"operands are inconsistent."};
+        }
+        if(j != std::string::npos && in_out)
+        {
+            batch.push_back(c);
+            nb *= av.shape()[i];
+        }
+        else if(j != std::string::npos)
+        {
+            contracted.push_back(c);
+            k *= av.shape()[i];
+        }
+        else
+        {
+            free_a.push_back(c);
+            m *= av.shape()[i];
+        }
+    }
+    for(size_t j = 0; j < lb.size(); j++)
+    {
+        if(la.find(lb[j]) == std::string::npos)
+        {
+            free_b.push_back(lb[j]);
+            n *= bv.shape()[j];
+        }
+    }
+    const std::string res_labels = batch + free_a + free_b;
+    for(char c : res_labels)
+    {
+        const size_t i = la.find(c);
+        out_shape.push_back(i != std::string::npos ? av.shape()[i] : bv.shape()[lb.find(c)]);
+    }
+
+    std::valarray<V> a_buffer, b_buffer;
+    const V* ap = detail::pack<V>(av, la, batch + free_a + contracted, a_buffer);
+    const V* bp = detail::pack<V>(bv, lb, batch + contracted + free_b, b_buffer);
+    DynamicTensor<V> res{out_shape};
+    V* cp = res.view().data();
+    for(size_t i = 0; i < nb; i++)
+    {
+        kernels::gemm(m, n, k, ap + i*m*k, k, bp + i*k*n, n, cp + i*m*n, n);
+    }
+    return detail::permute_to(std::move(res), res_labels, s.output);
+}
+
+}
+#endif // TENSOR_H
@@ -24,6 +24,7 @@ public:
     explicit Vector();
     explicit Vector(size_t s);
     explicit Vector(const std::valarray<T>& v);
+    explicit Vector(std::valarray<T>&& v); ///takes over the storage without copying
     Vector(std::initializer_list<T> l);
     ~Vector() = default;
     Vector(const Vector&) = default;
@@ -34,6 +35,12 @@ public:
     size_t size() const noexcept;
     void print() const;
     const std::valarray<value_type>& underlying_valarray() const noexcept;
+    container_type release() noexcept; ///moves the storage out and leaves an empty vector
+
+    value_type* begin() noexcept;
+    const value_type* begin() const noexcept;
+    value_type* end() noexcept;
+    const value_type* end() const noexcept;
 
     value_type& operator[](size_t);
     const value_type& operator[](size_t) const;
@@ -78,6 +85,9 @@ Vector<T>::Vector(size_t s):_size{s}, data(_size) {}
 template< typename T>
 Vector<T>::Vector(const std::valarray<T>& v):_size{v.size()}, data{v} {}
 
+template< typename T>
+Vector<T>::Vector(std::valarray<T>&& v):_size{v.size()}, data{std::move(v)} {}
+
 template< typename T>
 Vector<T>::Vector(std::initializer_list<T> l):_size{l.size()}, data(l) {}
 
@@ -180,6 +190,37 @@ const std::valarray<T>& Vector<T>::underlying_valarray() const noexcept
     return data;
 }
 
+template< typename T>
+Vector<T>::container_type Vector<T>::release() noexcept
+{
+    _size = 0;
+    return std::move(data);
+}
+
+template< typename T>
+Vector<T>::value_type* Vector<T>::begin() noexcept
+{
+    return std::begin(data);
+}
+
+template< typename T>
+const Vector<T>::value_type* Vector<T>::begin() const noexcept
+{
+    return std::begin(data);
+}
+
+template< typename T>
+Vector<T>::value_type* Vector<T>::end() noexcept
+{
+    return std::end(data);
+}
+
+template< typename T>
+const Vector<T>::value_type* Vector<T>::end() const noexcept
+{
+    return std::end(data);
+}
+
 template<typename T, typename U>
 requires std::same_as<T,U>
 bool operator==( const Vector<T>& r, const Vector<U>& l )
@@ -226,10 +267,7 @@ auto operator*( const Matrix<m, n, T>& l_m, const Vector<U>& r_v)
         throw wrong_operand{"operands are inconsistent."};
     }
     Vector<std::common_type_t<T,U>> res(l_m.rows);
-    for(size_t i = 0; i < res.size(); i++ )
-    {
-        res[i] = (l_m.underlying_valarray()[std::slice(i*l_m.cols, l_m.cols, 1)] * r_v.underlying_valarray()).sum();
-    }
+    kernels::gemv(l_m.rows, l_m.cols, l_m.begin(), l_m.cols, r_v.begin(), res.begin());
     return res;
 }
 
@@ -242,10 +280,7 @@ auto operator*(const Vector<T>& l_v, const Matrix<m, n, U>& r_m)
         throw wrong_operand{"operands are inconsistent."};
     }
     Vector<std::common_type_t<T,U>> res(r_m.cols);
-    for(size_t i = 0; i < res.size(); i++ )
-    {
-        res[i] = (r_m.underlying_valarray()[std::slice(i, r_m.rows, r_m.cols)] * l_v.underlying_valarray()).sum();
-    }
+    kernels::gevm(r_m.rows, r_m.cols, l_v.begin(), r_m.begin(), r_m.cols, res.begin());
     return res;
 }
 
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "IterativeSolvers.h"
+
+///Benchmarks the iterative solvers on a 2D poisson problem (5-point laplacian on a k x k grid).
+///usage: ./solver_bench [k]   default k = 256, i.e. 65536 unknowns.
+///Every allocation is counted so the report also shows that a solve does not allocate once the solver exists.
+
+namespace
+{
+std::atomic<size_t> allocations{0};
+}
+
+void* operator new(size_t s)
+{
+    allocations++;
+    if(void* p = std::malloc(s ? s : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+///gcc pairs the replaced new with free() when it inlines, which is exactly what is intended here
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+atlatec_test::CsrMatrix<double> poisson(size_t k)
+{
+    std::vector<atlatec_test::CsrMatrix<double>::triplet> e;
+    e.reserve(5*k*k);
+    for(size_t i = 0; i < k; i++)
+    {
+        for(size_t j = 0; j < k; j++)
+        {
+            const size_t row = i*k + j;
+            e.emplace_back(row, row, 4.0);
+            if(i > 0) e.emplace_back(row, row - k, -1.0);
+            if(i + 1 < k) e.emplace_back(row, row + k, -1.0);
+            if(j > 0) e.emplace_back(row, row - 1, -1.0);
+            if(j + 1 < k) e.emplace_back(row, row + 1, -1.0);
+        }
+    }
+    return atlatec_test::CsrMatrix<double>{k*k, k*k, e};
+}
+
+template<typename Solver, typename Op, typename P>
+void run(const std::string& name, Solver& solver, const Op& a, const atlatec_test::Vector<double>& b, const P& m, atlatec_test::SolverSettings settings)
+{
+    atlatec_test::Vector<double> x(b.size());
+    const size_t before = allocations.load();
+    const auto res = solver.solve(a, b, x, m, settings);
+    const size_t allocated = allocations.load() - before;
+    std::cout<<std::left<<std::setw(28)<<name<<std::right
+             <<std::setw(8)<<res.iterations
+             <<std::setw(14)<<std::scientific<<std::setprecision(2)<<res.relative_residual
+             <<std::setw(14)<<std::fixed<<std::setprecision(4)<<res.seconds
+             <<std::setw(14)<<std::setprecision(1)<<res.iterations_per_second()
+             <<std::setw(8)<<allocated
+             <<(res.converged ? "" : "  (not converged)")<<std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const size_t k = argc > 1 ? std::stoul(argv[1]) : 256;
+    const size_t n = k*k;
+    const auto a = poisson(k);
+    atlatec_test::Vector<double> b(n);
+    for(size_t i = 0; i < n; i++)
+    {
+        b[i] = 1.0;
+    }
+    const atlatec_test::SolverSettings settings{1e-8, 20000};
+    const atlatec_test::IdentityPreconditioner<double> none{};
+    const atlatec_test::JacobiPreconditioner<double> jacobi{a};
+    const atlatec_test::Ilu0Preconditioner<double> ilu{a};
+    auto stencil = [k](const double* x, double* y)
+    {
+        for(size_t i = 0; i < k; i++)
+        {
+            for(size_t j = 0; j < k; j++)
+            {
+                const size_t r = i*k + j;
+                double acc = 4.0*x[r];
+                if(i > 0) acc -= x[r - k];
+                if(i + 1 < k) acc -= x[r + k];
+                if(j > 0) acc -= x[r - 1];
+                if(j + 1 < k) acc -= x[r + 1];
+                y[r] = acc;
+            }
+        }
+    };
+
+    atlatec_test::ConjugateGradient<double> cg{n};
+    atlatec_test::BiCgStab<double> bicg{n};
+    atlatec_test::Gmres<double> gmres{n, 50};
+
+    std::cout<<"poisson "<<k<<"x"<<k<<", "<<n<<" unknowns, "<<a.non_zeros()<<" non-zeros, tolerance "<<settings.tolerance<<std::endl;
+    std::cout<<std::left<<std::setw(28)<<"solver"<<std::right<<std::setw(8)<<"iters"<<std::setw(14)<<"residual"
+             <<std::setw(14)<<"seconds"<<std::setw(14)<<"iters/s"<<std::setw(8)<<"allocs"<<std::endl;
+    run("cg", cg, a, b, none, settings);
+    run("cg + jacobi", cg, a, b, jacobi, settings);
+    run("cg + ilu(0)", cg, a, b, ilu, settings);
+    run("cg, matrix-free stencil", cg, stencil, b, none, settings);
+    run("bicgstab + jacobi", bicg, a, b, jacobi, settings);
+    run("bicgstab + ilu(0)", bicg, a, b, ilu, settings);
+    run("gmres(50) + jacobi", gmres, a, b, jacobi, settings);
+    run("gmres(50) + ilu(0)", gmres, a, b, ilu, settings);
+    return 0;
+}
@@ -1,5 +1,9 @@
 #include "Matrix.h"
 #include "Vector.h"
+#include "DynamicMatrix.h"
+#include "Tensor.h"
+#include "SparseMatrix.h"
+#include "IterativeSolvers.h"
 #include <gtest/gtest.h>
 #include <vector>
 #include <algorithm>
@@ -303,3 +307,300 @@ TEST(CommonTest,CommonMultiplication)
     atlatec_test::Vector<int> res11{2460, 411, 3408, 1131};
     EXPECT_EQ(res10,res11)<<"error in matrix-vector multiplication.";
 }
+
+TEST(DynamicMatrixTest,Construction)
+{
+    try
+    {
+        atlatec_test::DynamicMatrix<int> m{ {1,3,4,2,-5}, {2,-3,4,5,6}, {4,5,6,-7,0} };
+        EXPECT_EQ(m.rows(), 3)<<"wrong size.";
+        EXPECT_EQ(m.cols(), 5)<<"wrong size.";
+        EXPECT_EQ(m.at(2,3), -7)<<"error in subscription.";
+        atlatec_test::DynamicMatrix<float> p(100, 22);
+        EXPECT_EQ(p.size(), 2200)<<"wrong size.";
+        atlatec_test::DynamicMatrix<double> q{};
+        EXPECT_EQ(q.size(), 0)<<"wrong size.";
+    }
+    catch(const std::runtime_error& e)
+    {
+        FAIL()<<"correct construction causing exception: "<<e.what()<<std::endl;
+    }
+    try
+    {
+        atlatec_test::DynamicMatrix<int> m{ {1,3,4,5}, {2,3,4,5,6}, {4,5,6,7,0} };
+        FAIL()<<"Incorrect construction is being successfully done!"<<std::endl;
+    }
+    catch(const std::runtime_error& e) {}
+    try
+    {
+        atlatec_test::DynamicMatrix<int> s(3, 2, std::valarray<int>{1,2,3,4,5,6,7});
+        FAIL()<<"Incorrect construction is being successfully done!"<<std::endl;
+    }
+    catch(const std::runtime_error& e) {}
+    atlatec_test::DynamicMatrix<int> n(2, 4);
+    try{ n.at(1,4); FAIL()<<"wrong index accepted."; } catch(...){}
+    try{ n.at(2,0); FAIL()<<"wrong index accepted."; } catch(...){}
+}
+
+TEST(DynamicMatrixTest,StaticConversion)
+{
+    atlatec_test::Matrix<2, 4, int> n{ {1,4,2,5}, {2,4,5,6} };
+    const int* storage = n.begin();
+    atlatec_test::DynamicMatrix<int> d{std::move(n)};
+    EXPECT_EQ(d.begin(), storage)<<"static to dynamic must not copy.";
+    EXPECT_EQ(d.at(1,2), 5)<<"error in static to dynamic conversion.";
+    auto back = atlatec_test::to_matrix<2, 4>(std::move(d));
+    EXPECT_EQ(back.begin(), storage)<<"dynamic to static must not copy.";
+    EXPECT_EQ(back, (atlatec_test::Matrix<2, 4, int>{ {1,4,2,5}, {2,4,5,6} }))<<"error in dynamic to static conversion.";
+    atlatec_test::DynamicMatrix<int> e(3, 4);
+    try{ atlatec_test::to_matrix<2, 4>(std::move(e)); FAIL()<<"wrong dimensions accepted."; } catch(const std::runtime_error& e){}
+}
+
+TEST(DynamicMatrixTest,MixedOperations)
+{
+    atlatec_test::Matrix<3, 5, int> m0{ {1,3,4,2,5}, {2,3,4,5,6}, {4,5,6,7,0} };
+    atlatec_test::DynamicMatrix<int> d0{ {1,3,4,2,5}, {2,3,4,5,6}, {4,5,6,7,0} };
+    atlatec_test::Matrix<5, 2, int> n0{ {1,5}, {3,6}, {4,0}, {2,5}, {3,2} };
+    atlatec_test::DynamicMatrix<int> e0{ {1,5}, {3,6}, {4,0}, {2,5}, {3,2} };
+    atlatec_test::Matrix<3,2, int> res0{{45,43}, {55,65}, {57,85}};
+    EXPECT_EQ(d0*e0, res0)<<"wrong multiplication outcome.";
+    EXPECT_EQ(m0*e0, res0)<<"wrong multiplication outcome.";
+    EXPECT_EQ(d0*n0, res0)<<"wrong multiplication outcome.";
+    try{ e0*m0; FAIL()<<"inconsistent operands accepted."; } catch(const std::runtime_error& e){}
+
+    atlatec_test::DynamicMatrix<double> d1{ {0.4,0}, {-47.1,32.4}, {-4,4.11}, {-4, 5.01} };
+    atlatec_test::Matrix<4, 2, double> n1{ {1,2}, {2,-1}, {3,4}, {-4, 5} };
+    atlatec_test::Matrix<4,2, double> res1{{1.4,2}, {-45.1,31.4}, {-1,8.11}, {-8,10.01}};
+    EXPECT_EQ(d1+n1, res1)<<"wrong addition outcome.";
+    EXPECT_EQ(n1+d1, res1)<<"wrong addition outcome.";
+    try{ d0+e0; FAIL()<<"inconsistent operands accepted."; } catch(const std::runtime_error& e){}
+
+    atlatec_test::DynamicMatrix<int> d2{ {1,2}, {2,-1}, {3,4}, {-4, 5} };
+    atlatec_test::Matrix<4,2, int> res2{{12,24}, {24,-12}, {36,48}, {-48,60}};
+    EXPECT_EQ(12*d2, res2)<<"wrong multiplication outcome.";
+    EXPECT_EQ(d2*12, res2)<<"wrong multiplication outcome.";
+
+    atlatec_test::Vector<int> v1{9,8,6,7,8,9,34};
+    atlatec_test::DynamicMatrix<int> m1{{78,68,68,56,9,4,9}, {6,7,9,5,3,2,5}, {76,74,22,3,55,1,45},{0,56,78,9,4,2,3}};
+    EXPECT_EQ(m1*v1, (atlatec_test::Vector<int>{2460, 411, 3408, 1131}))<<"error in matrix-vector multiplication.";
+    atlatec_test::Vector<double> v0{2.2,1.3,7.1};
+    atlatec_test::DynamicMatrix<double> m2{{1.1,1.2,5.5}, {2.3,1.3,5}, {9.5,1.4,8.1}};
+    EXPECT_EQ(v0*m2, (atlatec_test::Vector<double>{72.86, 14.27, 76.11}))<<"error in vector-matrix multiplication.";
+    try{ v1*m1; FAIL()<<"inconsistent operands accepted."; } catch(const std::runtime_error& e){}
+}
+
+TEST(TensorTest,ViewReshapePermute)
+{
+    atlatec_test::Tensor<int, 2, 3, 4> t{};
+    for(size_t i = 0; i < t.size; i++)
+    {
+        t.view().data()[i] = static_cast<int>(i);
+    }
+    EXPECT_EQ(t(1,2,3), 23)<<"error in tensor subscription.";
+    EXPECT_EQ(t(0,1,2), 6)<<"error in tensor subscription.";
+
+    auto v = t.view();
+    auto r = v.reshape({6, 4});
+    EXPECT_EQ(r.data(), v.data())<<"reshape must not copy.";
+    EXPECT_EQ(r.at({5,3}), 23)<<"error in tensor reshape.";
+
+    auto p = v.permute({2, 0, 1});
+    EXPECT_EQ(p.shape(), (atlatec_test::shape_type{4, 2, 3}))<<"error in tensor permute.";
+    EXPECT_EQ(p.at({3,1,2}), 23)<<"error in tensor permute.";
+    EXPECT_EQ(p.at({1,0,2}), 9)<<"error in tensor permute.";
+    EXPECT_FALSE(p.is_contiguous());
+    try{ p.reshape({24}); FAIL()<<"non-contiguous reshape accepted."; } catch(const std::runtime_error& e){}
+    try{ v.at({2,0,0}); FAIL()<<"wrong index accepted."; } catch(...){}
+
+    atlatec_test::DynamicTensor<int> d{p};
+    EXPECT_EQ(d.at({3,1,2}), 23)<<"error in tensor copy from view.";
+    EXPECT_EQ(d[1], 4)<<"error in tensor copy from view.";
+
+    auto s = std::move(t).reshape<4, 6>();
+    EXPECT_EQ(s(3,5), 23)<<"error in static tensor reshape.";
+}
+
+TEST(TensorTest,MatrixVectorConversion)
+{
+    atlatec_test::Matrix<2, 3, int> m{ {1,2,3}, {4,5,6} };
+    const int* storage = m.begin();
+    auto mv = atlatec_test::as_tensor(m);
+    EXPECT_EQ(mv.data(), storage)<<"view must alias the matrix.";
+    mv.at({1,1}) = 50;
+    EXPECT_EQ(m.at(1,1), 50)<<"view must alias the matrix.";
+
+    auto t = atlatec_test::to_tensor(std::move(m));
+    EXPECT_EQ(t.view().data(), storage)<<"matrix to tensor must not copy.";
+    auto back = atlatec_test::to_matrix(std::move(t));
+    EXPECT_EQ(back.begin(), storage)<<"tensor to matrix must not copy.";
+    atlatec_test::Matrix<2, 3, int> expected{ {1,2,3}, {4,50,6} };
+    EXPECT_EQ(back, expected)<<"error in matrix-tensor conversion.";
+
+    atlatec_test::Vector<double> v{1.5, 2.5, 3.5};
+    const double* v_storage = v.begin();
+    auto vt = atlatec_test::to_tensor(std::move(v));
+    EXPECT_EQ(vt.view().data(), v_storage)<<"vector to tensor must not copy.";
+    auto vb = atlatec_test::to_vector(std::move(vt));
+    EXPECT_EQ(vb.begin(), v_storage)<<"tensor to vector must not copy.";
+    EXPECT_EQ(vb, (atlatec_test::Vector<double>{1.5, 2.5, 3.5}))<<"error in vector-tensor conversion.";
+}
+
+TEST(TensorTest,Einsum)
+{
+    atlatec_test::Matrix<4, 2, int> m1{ {1,2}, {2,-1}, {3,4}, {-4, 5} };
+    atlatec_test::Matrix<2, 4, int> n1{ {8,-9,2,0}, {0,1,-2,9} };
+    auto mm = atlatec_test::einsum("ij,jk->ik", atlatec_test::as_tensor(m1), atlatec_test::as_tensor(n1));
+    EXPECT_EQ((atlatec_test::to_matrix<4, 4>(std::move(mm))), m1*n1)<<"error in einsum matrix product.";
+
+    auto mt = atlatec_test::einsum("ji,jk->ki", atlatec_test::as_tensor(m1).permute({1, 0}), atlatec_test::as_tensor(n1));
+    atlatec_test::Matrix<4, 4, int> res{{8,16,24,-32}, {-7,-19,-23,41}, {-2,6,-2,-18}, {18,-9,36,45}};
+    EXPECT_EQ((atlatec_test::to_matrix<4, 4>(std::move(mt))), res)<<"error in einsum with transposed operands.";
+
+    atlatec_test::Tensor<double, 2, 2, 3> a{{1,2,3, 4,5,6,  1,0,0, 0,1,0}};
+    atlatec_test::Tensor<double, 2, 3, 2> b{{1,0, 0,1, 1,1,  2,3, 4,5, 6,7}};
+    auto bmm = atlatec_test::einsum("bij,bjk->bik", a.view(), b.view());
+    atlatec_test::DynamicTensor<double> bmm_expected{{2,2,2}, {4,5, 10,11,  2,3, 4,5}};
+    EXPECT_EQ(bmm.shape(), bmm_expected.shape())<<"error in batched einsum.";
+    EXPECT_TRUE(std::abs(bmm.underlying_valarray()-bmm_expected.underlying_valarray()).max() < 1e-12)<<"error in batched einsum.";
+
+    atlatec_test::Matrix<3, 3, int> sq{ {1,2,3}, {4,5,6}, {7,8,9} };
+    EXPECT_EQ(atlatec_test::einsum("ii->", atlatec_test::as_tensor(sq))[0], 15)<<"error in einsum trace.";
+    auto diag = atlatec_test::einsum("ii->i", atlatec_test::as_tensor(sq));
+    EXPECT_EQ(atlatec_test::to_vector(std::move(diag)), (atlatec_test::Vector<int>{1,5,9}))<<"error in einsum diagonal.";
+    auto col_sum = atlatec_test::einsum("ij->j", atlatec_test::as_tensor(sq));
+    EXPECT_EQ(atlatec_test::to_vector(std::move(col_sum)), (atlatec_test::Vector<int>{12,15,18}))<<"error in einsum reduction.";
+
+    atlatec_test::Vector<int> v{1,2,3};
+    auto mv = atlatec_test::einsum("ij,j->i", atlatec_test::as_tensor(sq), atlatec_test::as_tensor(v));
+    EXPECT_EQ(atlatec_test::to_vector(std::move(mv)), sq*v)<<"error in einsum matrix-vector product.";
+    auto dot_sum = atlatec_test::einsum("ij,k->", atlatec_test::as_tensor(sq), atlatec_test::as_tensor(v));
+    EXPECT_EQ(dot_sum[0], 45*6)<<"error in einsum with summed-out labels.";
+
+    try{ atlatec_test::einsum("ij,jk", atlatec_test::as_tensor(m1), atlatec_test::as_tensor(n1)); FAIL()<<"implicit output accepted."; } catch(const std::runtime_error& e){}
+    try{ atlatec_test::einsum("ij,ik->jk", atlatec_test::as_tensor(m1), atlatec_test::as_tensor(n1)); FAIL()<<"inconsistent operands accepted."; } catch(const std::runtime_error& e){}
+}
+
+namespace
+{
+///5-point laplacian on a k x k grid, symmetric positive definite
+atlatec_test::CsrMatrix<double> laplacian(size_t k, double shift = 0)
+{
+    std::vector<atlatec_test::CsrMatrix<double>::triplet> e;
+    for(size_t i = 0; i < k; i++)
+    {
+        for(size_t j = 0; j < k; j++)
+        {
+            const size_t row = i*k + j;
+            e.emplace_back(row, row, 4.0);
+            if(i > 0) e.emplace_back(row, row - k, -1.0);
+            if(i + 1 < k) e.emplace_back(row, row + k, -1.0 + shift);
+            if(j > 0) e.emplace_back(row, row - 1, -1.0);
+            if(j + 1 < k) e.emplace_back(row, row + 1, -1.0 + shift);
+        }
+    }
+    return atlatec_test::CsrMatrix<double>{k*k, k*k, e};
+}
+
+double relative_error(const atlatec_test::Vector<double>& a, const atlatec_test::Vector<double>& b)
+{
+    return std::sqrt(std::pow(a.underlying_valarray() - b.underlying_valarray(), 2.0).sum()/std::pow(b.underlying_valarray(), 2.0).sum());
+}
+}
+
+TEST(SparseMatrixTest,Construction)
+{
+    atlatec_test::CsrMatrix<int> a{3, 3, {{2,1,5}, {0,0,1}, {1,1,3}, {0,2,2}, {2,1,1}}};
+    EXPECT_EQ(a.non_zeros(), 4)<<"duplicates must be summed.";
+    EXPECT_EQ(a.row_offsets(), (std::vector<size_t>{0, 2, 3, 4}))<<"wrong row offsets.";
+    EXPECT_EQ(a.diagonal(), (std::vector<int>{1, 3, 0}))<<"wrong diagonal.";
+    EXPECT_EQ((a*atlatec_test::Vector<int>{1,2,3}), (atlatec_test::Vector<int>{7, 6, 12}))<<"error in sparse matrix-vector multiplication.";
+    atlatec_test::Matrix<4, 7, int> m1{{78,68,68,56,9,4,9}, {6,7,9,5,3,2,5}, {76,74,22,3,55,1,45},{0,56,78,9,4,2,3}};
+    atlatec_test::CsrMatrix<int> s1{m1};
+    EXPECT_EQ(s1.non_zeros(), 27)<<"zeros must be dropped.";
+    EXPECT_EQ((s1*atlatec_test::Vector<int>{9,8,6,7,8,9,34}), (atlatec_test::Vector<int>{2460, 411, 3408, 1131}))<<"error in sparse matrix-vector multiplication.";
+    try{ atlatec_test::CsrMatrix<int> b{2, 2, {{2,0,1}}}; FAIL()<<"out of range entry accepted."; } catch(const std::runtime_error& e){}
+}
+
+TEST(SolverTest,ConjugateGradient)
+{
+    const auto a = laplacian(12);
+    atlatec_test::Vector<double> expected(a.rows());
+    for(size_t i = 0; i < expected.size(); i++)
+    {
+        expected[i] = std::sin(0.1*i);
+    }
+    const auto b = a*expected;
+    atlatec_test::ConjugateGradient<double> cg{a.rows()};
+
+    atlatec_test::Vector<double> x0(a.rows());
+    auto r0 = cg.solve(a, b, x0);
+    EXPECT_TRUE(r0.converged)<<"cg did not converge.";
+    EXPECT_LT(relative_error(x0, expected), 1e-6)<<"wrong cg solution.";
+
+    atlatec_test::Vector<double> x1(a.rows());
+    auto r1 = cg.solve(a, b, x1, atlatec_test::Ilu0Preconditioner<double>{a});
+    EXPECT_TRUE(r1.converged)<<"ilu(0) preconditioned cg did not converge.";
+    EXPECT_LT(r1.iterations, r0.iterations)<<"ilu(0) should reduce the iteration count.";
+    EXPECT_LT(relative_error(x1, expected), 1e-6)<<"wrong preconditioned cg solution.";
+
+    atlatec_test::Matrix<3, 3, double> d{{4,1,0}, {1,3,1}, {0,1,2}};
+    atlatec_test::Vector<double> dx(3);
+    auto rd = atlatec_test::ConjugateGradient<double>{3}.solve(d, atlatec_test::Vector<double>{1,2,3}, dx, atlatec_test::JacobiPreconditioner<double>{d});
+    EXPECT_TRUE(rd.converged)<<"cg on a dense matrix did not converge.";
+    EXPECT_EQ(d*dx, (atlatec_test::Vector<double>{1,2,3}))<<"wrong cg solution on a dense matrix.";
+
+    atlatec_test::Vector<double> wrong(5);
+    try{ cg.solve(a, b, wrong); FAIL()<<"inconsistent operands accepted."; } catch(const std::runtime_error& e){}
+}
+
+TEST(SolverTest,PreconditionerSize)
+{
+    const auto a = laplacian(3);
+    const atlatec_test::Matrix<5, 5, double> big{{4,1,0,0,0}, {1,4,1,0,0}, {0,1,4,1,0}, {0,0,1,4,1}, {0,0,0,1,4}};
+    const atlatec_test::Vector<double> b{1,2,3};
+    atlatec_test::Vector<double> x(3);
+    const atlatec_test::Matrix<3, 3, double> d{{4,1,0}, {1,3,1}, {0,1,2}};
+    EXPECT_THROW(atlatec_test::ConjugateGradient<double>{3}.solve(d, b, x, atlatec_test::JacobiPreconditioner<double>{big}), atlatec_test::wrong_operand);
+    EXPECT_THROW(atlatec_test::BiCgStab<double>{3}.solve(d, b, x, atlatec_test::Ilu0Preconditioner<double>{a}), atlatec_test::wrong_operand);
+    EXPECT_THROW(atlatec_test::Gmres<double>{3}.solve(d, b, x, atlatec_test::JacobiPreconditioner<double>{a}), atlatec_test::wrong_operand);
+}
+
+TEST(SolverTest,BiCgStabAndGmres)
+{
+    const auto a = laplacian(10, 0.4); ///non-symmetric
+    atlatec_test::Vector<double> expected(a.rows());
+    for(size_t i = 0; i < expected.size(); i++)
+    {
+        expected[i] = std::cos(0.3*i);
+    }
+    const auto b = a*expected;
+
+    atlatec_test::BiCgStab<double> bicg{a.rows()};
+    atlatec_test::Vector<double> x0(a.rows());
+    auto r0 = bicg.solve(a, b, x0, atlatec_test::JacobiPreconditioner<double>{a});
+    EXPECT_TRUE(r0.converged)<<"bicgstab did not converge.";
+    EXPECT_LT(relative_error(x0, expected), 1e-6)<<"wrong bicgstab solution.";
+
+    atlatec_test::Gmres<double> gmres{a.rows(), 20};
+    atlatec_test::Vector<double> x1(a.rows());
+    auto r1 = gmres.solve(a, b, x1, atlatec_test::Ilu0Preconditioner<double>{a});
+    EXPECT_TRUE(r1.converged)<<"gmres did not converge.";
+    EXPECT_LT(relative_error(x1, expected), 1e-6)<<"wrong gmres solution.";
+
+    ///matrix-free operator, the same system through a lambda
+    auto op = [&a](const double* x, double* y){ a.multiply(x, y); };
+    atlatec_test::Vector<double> x2(a.rows());
+    atlatec_test::SolverSettings few{1e-8, 5};
+    auto r2 = gmres.solve(op, b, x2, atlatec_test::IdentityPreconditioner<double>{}, few);
+    EXPECT_FALSE(r2.converged)<<"iteration limit ignored.";
+    EXPECT_EQ(r2.iterations, 5)<<"iteration limit ignored.";
+    auto r3 = gmres.solve(op, b, x2);
+    EXPECT_TRUE(r3.converged)<<"restarted gmres with a lambda operator did not converge.";
+    EXPECT_LT(relative_error(x2, expected), 1e-6)<<"wrong gmres solution.";
+
+    atlatec_test::DynamicMatrix<double> d{{4,1,0}, {2,3,1}, {0,-1,2}};
+    atlatec_test::Vector<double> dx(3);
+    auto rd = atlatec_test::BiCgStab<double>{3}.solve(d, atlatec_test::Vector<double>{1,2,3}, dx);
+    EXPECT_TRUE(rd.converged)<<"bicgstab on a dense matrix did not converge.";
+    EXPECT_EQ(d*dx, (atlatec_test::Vector<double>{1,2,3}))<<"wrong bicgstab solution on a dense matrix.";
+}